@@ -0,0 +1,158 @@
+#include <inttypes.h>
+#include <json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ipc-json-buffer.h"
+#include "log.h"
+
+static bool json_buffer_reserve(struct ipc_json_buffer *buf, size_t size) {
+	if (buf->failed) {
+		return false;
+	}
+	if (buf->length + size <= buf->capacity) {
+		return true;
+	}
+	size_t capacity = buf->capacity ? buf->capacity : 4096;
+	while (capacity < buf->length + size) {
+		capacity *= 2;
+	}
+	char *data = realloc(buf->data, capacity);
+	if (!data) {
+		sway_log(SWAY_ERROR, "Unable to allocate JSON buffer");
+		buf->failed = true;
+		return false;
+	}
+	buf->data = data;
+	buf->capacity = capacity;
+	return true;
+}
+
+static void json_buffer_append(struct ipc_json_buffer *buf, const char *str,
+		size_t len) {
+	if (json_buffer_reserve(buf, len)) {
+		memcpy(buf->data + buf->length, str, len);
+		buf->length += len;
+	}
+}
+
+#define json_buffer_append_literal(buf, str) \
+	json_buffer_append(buf, str, sizeof(str) - 1)
+
+// Same escaping as json-c without JSON_C_TO_STRING_NOSLASHESCAPE
+static void json_buffer_append_string(struct ipc_json_buffer *buf,
+		const char *str) {
+	static const char hex[] = "0123456789abcdef";
+	json_buffer_append_literal(buf, "\"");
+	const char *start = str;
+	for (const char *p = str; *p; ++p) {
+		unsigned char c = *p;
+		const char *escape = NULL;
+		char unicode[7];
+		switch (c) {
+		case '\b': escape = "\\b"; break;
+		case '\n': escape = "\\n"; break;
+		case '\r': escape = "\\r"; break;
+		case '\t': escape = "\\t"; break;
+		case '\f': escape = "\\f"; break;
+		case '"': escape = "\\\""; break;
+		case '\\': escape = "\\\\"; break;
+		case '/': escape = "\\/"; break;
+		default:
+			if (c < ' ') {
+				snprintf(unicode, sizeof(unicode), "\\u00%c%c",
+					hex[c >> 4], hex[c & 0xf]);
+				escape = unicode;
+			}
+			break;
+		}
+		if (escape) {
+			json_buffer_append(buf, start, p - start);
+			json_buffer_append(buf, escape, strlen(escape));
+			start = p + 1;
+		}
+	}
+	json_buffer_append(buf, start, strlen(start));
+	json_buffer_append_literal(buf, "\"");
+}
+
+void ipc_json_write_object_begin(struct ipc_json_buffer *buf) {
+	json_buffer_append_literal(buf, "{");
+	buf->first = true;
+}
+
+void ipc_json_write_key(struct ipc_json_buffer *buf, const char *key) {
+	if (!buf->first) {
+		json_buffer_append_literal(buf, ",");
+	}
+	json_buffer_append_literal(buf, " ");
+	json_buffer_append_string(buf, key);
+	json_buffer_append_literal(buf, ": ");
+}
+
+void ipc_json_write_object_end(struct ipc_json_buffer *buf) {
+	json_buffer_append_literal(buf, " }");
+	buf->first = false;
+}
+
+void ipc_json_write_array_begin(struct ipc_json_buffer *buf) {
+	json_buffer_append_literal(buf, "[");
+	buf->first = true;
+}
+
+void ipc_json_write_array_item(struct ipc_json_buffer *buf) {
+	if (!buf->first) {
+		json_buffer_append_literal(buf, ",");
+	}
+	json_buffer_append_literal(buf, " ");
+}
+
+void ipc_json_write_array_end(struct ipc_json_buffer *buf) {
+	json_buffer_append_literal(buf, " ]");
+	buf->first = false;
+}
+
+void ipc_json_write(struct ipc_json_buffer *buf, json_object *object) {
+	char num[32];
+	switch (json_object_get_type(object)) {
+	case json_type_null:
+		json_buffer_append_literal(buf, "null");
+		break;
+	case json_type_boolean:
+		if (json_object_get_boolean(object)) {
+			json_buffer_append_literal(buf, "true");
+		} else {
+			json_buffer_append_literal(buf, "false");
+		}
+		break;
+	case json_type_int:
+		snprintf(num, sizeof(num), "%" PRId64, json_object_get_int64(object));
+		json_buffer_append(buf, num, strlen(num));
+		break;
+	case json_type_double:;
+		// Leave the number formatting details to json-c
+		const char *str = json_object_to_json_string(object);
+		json_buffer_append(buf, str, strlen(str));
+		break;
+	case json_type_string:
+		json_buffer_append_string(buf, json_object_get_string(object));
+		break;
+	case json_type_object:
+		ipc_json_write_object_begin(buf);
+		json_object_object_foreach(object, key, value) {
+			ipc_json_write_key(buf, key);
+			ipc_json_write(buf, value);
+		}
+		ipc_json_write_object_end(buf);
+		break;
+	case json_type_array:
+		ipc_json_write_array_begin(buf);
+		for (size_t i = 0; i < json_object_array_length(object); ++i) {
+			ipc_json_write_array_item(buf);
+			ipc_json_write(buf, json_object_array_get_idx(object, i));
+		}
+		ipc_json_write_array_end(buf);
+		break;
+	}
+	buf->first = false;
+}
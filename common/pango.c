@@ -50,11 +50,8 @@ size_t escape_markup_text(const char *src, char *dest) {
 	return length;
 }
 
-PangoLayout *get_pango_layout(cairo_t *cairo, const PangoFontDescription *desc,
-		const char *text, double scale, bool markup) {
-	PangoLayout *layout = pango_cairo_create_layout(cairo);
-	pango_context_set_round_glyph_positions(pango_layout_get_context(layout), false);
-
+PangoAttrList *set_pango_layout_text(PangoLayout *layout, const char *text,
+		bool markup) {
 	PangoAttrList *attrs;
 	if (markup) {
 		char *buf;
@@ -73,11 +70,26 @@ PangoLayout *get_pango_layout(cairo_t *cairo, const PangoFontDescription *desc,
 		attrs = pango_attr_list_new();
 		pango_layout_set_text(layout, text, -1);
 	}
+	return attrs;
+}
+
+void set_pango_layout_scale(PangoLayout *layout, PangoAttrList *attrs,
+		double scale) {
+	PangoAttrList *scaled = pango_attr_list_copy(attrs);
+	pango_attr_list_insert(scaled, pango_attr_scale_new(scale));
+	pango_layout_set_attributes(layout, scaled);
+	pango_attr_list_unref(scaled);
+}
+
+PangoLayout *get_pango_layout(cairo_t *cairo, const PangoFontDescription *desc,
+		const char *text, double scale, bool markup) {
+	PangoLayout *layout = pango_cairo_create_layout(cairo);
+	pango_context_set_round_glyph_positions(pango_layout_get_context(layout), false);
 
-	pango_attr_list_insert(attrs, pango_attr_scale_new(scale));
+	PangoAttrList *attrs = set_pango_layout_text(layout, text, markup);
 	pango_layout_set_font_description(layout, desc);
 	pango_layout_set_single_paragraph_mode(layout, 1);
-	pango_layout_set_attributes(layout, attrs);
+	set_pango_layout_scale(layout, attrs, scale);
 	pango_attr_list_unref(attrs);
 	return layout;
 }
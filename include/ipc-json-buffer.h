@@ -0,0 +1,29 @@
+#ifndef _SWAY_IPC_JSON_BUFFER_H
+#define _SWAY_IPC_JSON_BUFFER_H
+
+#include <json.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A growable buffer that JSON is written into directly, formatted exactly like
+ * json_object_to_json_string does it. Allocation failures are sticky and
+ * reported through failed.
+ */
+struct ipc_json_buffer {
+	char *data;
+	size_t length;
+	size_t capacity;
+	bool failed;
+	bool first; // no value has been written to the current object or array
+};
+
+void ipc_json_write(struct ipc_json_buffer *buf, json_object *object);
+void ipc_json_write_object_begin(struct ipc_json_buffer *buf);
+void ipc_json_write_key(struct ipc_json_buffer *buf, const char *key);
+void ipc_json_write_object_end(struct ipc_json_buffer *buf);
+void ipc_json_write_array_begin(struct ipc_json_buffer *buf);
+void ipc_json_write_array_item(struct ipc_json_buffer *buf);
+void ipc_json_write_array_end(struct ipc_json_buffer *buf);
+
+#endif
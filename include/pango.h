@@ -14,6 +14,17 @@
  * escaped string to dest if provided.
  */
 size_t escape_markup_text(const char *src, char *dest);
+/**
+ * Set the text of a layout, parsing it as Pango markup if requested. Returns
+ * the attributes of the markup, which the caller must unref.
+ */
+PangoAttrList *set_pango_layout_text(PangoLayout *layout, const char *text,
+		bool markup);
+/**
+ * Apply attrs to the layout with text scaled by the given factor.
+ */
+void set_pango_layout_scale(PangoLayout *layout, PangoAttrList *attrs,
+		double scale);
 PangoLayout *get_pango_layout(cairo_t *cairo, const PangoFontDescription *desc,
 		const char *text, double scale, bool markup);
 void get_text_size(cairo_t *cairo, const PangoFontDescription *desc, int *width, int *height,
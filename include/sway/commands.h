@@ -59,6 +59,21 @@ const struct cmd_handler *find_handler(const char *line,
  */
 list_t *execute_command(char *command,  struct sway_seat *seat,
 		struct sway_container *con);
+
+struct compiled_command_list;
+
+/**
+ * Executes a command like execute_command, but keeps the parsed commands in
+ * `*compiled` so that later executions of the same command string skip
+ * splitting, variable replacement, criteria parsing and handler lookup.
+ *
+ * Commands which can't be compiled fall back to execute_command. The compiled
+ * form is discarded if a variable is set in the meantime.
+ */
+list_t *execute_compiled_command(struct compiled_command_list **compiled,
+		char *command, struct sway_seat *seat, struct sway_container *con);
+
+void compiled_command_list_destroy(struct compiled_command_list *compiled);
 /**
  * Parse and handles a command during config file loading.
  *
@@ -147,6 +162,7 @@ sway_cmd cmd_hide_edge_borders;
 sway_cmd cmd_include;
 sway_cmd cmd_inhibit_idle;
 sway_cmd cmd_input;
+sway_cmd cmd_ipc_client_backlog;
 sway_cmd cmd_seat;
 sway_cmd cmd_ipc;
 sway_cmd cmd_kill;
@@ -312,6 +328,7 @@ sway_cmd seat_cmd_hide_cursor;
 sway_cmd seat_cmd_idle_inhibit;
 sway_cmd seat_cmd_idle_wake;
 sway_cmd seat_cmd_keyboard_grouping;
+sway_cmd seat_cmd_pointer_batching;
 sway_cmd seat_cmd_pointer_constraint;
 sway_cmd seat_cmd_shortcuts_inhibitor;
 sway_cmd seat_cmd_xcursor_theme;
@@ -66,6 +66,7 @@ struct sway_binding {
 	uint32_t modifiers;
 	xkb_layout_index_t group;
 	char *command;
+	struct compiled_command_list *compiled_command; // NULL until first run
 };
 
 enum sway_switch_trigger {
@@ -115,6 +116,11 @@ struct sway_mode {
 	list_t *switch_bindings;
 	list_t *gesture_bindings;
 	bool pango;
+
+	// Lookup tables for keysym_bindings and keycode_bindings, built on demand
+	// by the keyboard code. See sway_mode_reset_binding_index.
+	struct sway_binding_index *keysym_index;
+	struct sway_binding_index *keycode_index;
 };
 
 struct input_config_mapped_from_region {
@@ -226,6 +232,12 @@ enum seat_keyboard_grouping {
 	KEYBOARD_GROUP_SMART, // keymap and repeat info
 };
 
+enum seat_config_pointer_batching {
+	POINTER_BATCHING_DEFAULT, // the default is currently disabled
+	POINTER_BATCHING_ENABLE,
+	POINTER_BATCHING_DISABLE,
+};
+
 enum sway_input_idle_source {
 	IDLE_SOURCE_KEYBOARD = 1 << 0,
 	IDLE_SOURCE_POINTER = 1 << 1,
@@ -247,6 +259,7 @@ struct seat_config {
 	enum seat_config_allow_constrain allow_constrain;
 	enum seat_config_shortcuts_inhibit shortcuts_inhibit;
 	enum seat_keyboard_grouping keyboard_grouping;
+	enum seat_config_pointer_batching pointer_batching;
 	uint32_t idle_inhibit_sources, idle_wake_sources;
 	struct {
 		char *name;
@@ -494,6 +507,7 @@ struct sway_config {
 	char *swaynag_command;
 	struct swaynag_instance swaynag_config_errors;
 	list_t *symbols;
+	int symbols_serial; // incremented whenever a variable is set
 	list_t *modes;
 	list_t *bars;
 	list_t *cmd_queue;
@@ -503,6 +517,8 @@ struct sway_config {
 	list_t *input_type_configs;
 	list_t *seat_configs;
 	list_t *criteria;
+	struct criteria_index *criteria_index; // built on demand from criteria
+	uint32_t criteria_generation; // unique to this config's criteria list
 	list_t *no_focus;
 	list_t *active_bar_modifiers;
 	struct sway_mode *current_mode;
@@ -529,6 +545,7 @@ struct sway_config {
 	enum sway_fowa focus_on_window_activation;
 	enum sway_popup_during_fullscreen popup_during_fullscreen;
 	enum xwayland_mode xwayland;
+	size_t ipc_client_backlog; // bytes, 0 for no limit
 
 	// swaybg
 	char *swaybg_command;
@@ -27,13 +27,30 @@ enum pattern_type {
 struct pattern {
 	enum pattern_type match_type;
 	pcre2_code *regex;
+	pcre2_match_data *match_data;
+
+	// Set when the regex is a plain string, optionally anchored with ^ and $,
+	// so it can be matched without running pcre2
+	char *literal;
+	size_t literal_len;
+	bool anchored_start, anchored_end;
 };
 
+struct criteria_index;
+
 struct criteria {
 	enum criteria_type type;
 	char *raw; // entire criteria string (for logging)
 	char *cmdlist;
+	struct compiled_command_list *compiled_cmdlist; // NULL until first run
 	char *target; // workspace or output name for `assign` criteria
+	int position; // in config->criteria, -1 if not added
+
+	// Bitmask of the enum view_criteria_dep groups the criteria depends on.
+	// Volatile criteria also depend on focus, layout or other views, so their
+	// results are never cached.
+	uint32_t dependencies;
+	bool is_volatile;
 
 	struct pattern *title;
 	struct pattern *shell;
@@ -76,6 +93,24 @@ void criteria_destroy(struct criteria *criteria);
  */
 struct criteria *criteria_parse(char *raw, char **error);
 
+/**
+ * Append the criteria to the config's criteria list and invalidate the
+ * criteria index.
+ */
+void criteria_add(struct criteria *criteria);
+
+/**
+ * Destroy an index built by criteria_for_view. Used when the criteria list
+ * it was built from is freed.
+ */
+void criteria_index_destroy(struct criteria_index *index);
+
+/**
+ * Record that the commands of a CT_COMMAND criteria have been run on the view.
+ * Returns false if they already were.
+ */
+bool criteria_set_executed(struct criteria *criteria, struct sway_view *view);
+
 /**
  * Compile a list of criterias matching the given view.
  *
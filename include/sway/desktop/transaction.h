@@ -22,6 +22,7 @@
  */
 
 struct sway_transaction_instruction;
+struct sway_container;
 struct sway_view;
 
 /**
@@ -36,6 +37,18 @@ void transaction_commit_dirty(void);
  */
 void transaction_commit_dirty_client(void);
 
+/**
+ * Mark a container as dirty unless a transaction would not change it: no
+ * transaction is in flight for it and the state that would be copied into an
+ * instruction equals its current state. Returns true if it is dirty.
+ */
+bool transaction_set_dirty_if_changed(struct sway_container *con);
+
+/**
+ * Free the instructions and lists kept for reuse by later transactions.
+ */
+void transaction_pool_finish(void);
+
 /**
  * Notify the transaction system that a view is ready for the new layout.
  *
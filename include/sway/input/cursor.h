@@ -80,6 +80,19 @@ struct sway_cursor {
 	enum seat_config_hide_cursor_when_typing hide_when_typing;
 
 	size_t pressed_button_count;
+
+	// Whether seatop motion handling is deferred until the event loop has
+	// drained the pending input events, see cursor_flush_motion. Cache of
+	// seat_config->pointer_batching.
+	bool motion_batching;
+	struct {
+		bool pending; // seatop_pointer_motion is owed for the cursor position
+		bool frame; // a pointer frame followed the pending motion
+		uint32_t time_msec;
+		struct wl_event_source *idle;
+
+		uint64_t batches, coalesced;
+	} motion_batch;
 };
 
 struct sway_node;
@@ -112,6 +125,13 @@ void pointer_motion(struct sway_cursor *cursor, uint32_t time_msec,
 		struct wlr_input_device *device, double dx, double dy,
 		double dx_unaccel, double dy_unaccel);
 
+/**
+ * Run the seatop motion handling owed for batched pointer motion, if any.
+ * Called before any other input event is handled so that it is delivered in
+ * order.
+ */
+void cursor_flush_motion(struct sway_cursor *cursor);
+
 void dispatch_cursor_button(struct sway_cursor *cursor,
 	struct wlr_input_device *device, uint32_t time_msec, uint32_t button,
 	enum wl_pointer_button_state state);
@@ -26,6 +26,13 @@ const char *get_modifier_name_by_mask(uint32_t modifier);
  */
 int get_modifier_names(const char **names, uint32_t modifier_masks);
 
+/**
+ * Drop the key binding lookup tables of a mode, which are rebuilt on the next
+ * key event. Must be called whenever the keysym or keycode bindings of the
+ * mode change.
+ */
+void sway_mode_reset_binding_index(struct sway_mode *mode);
+
 struct sway_shortcut_state {
 	/**
 	 * A list of pressed key ids (either keysyms or keycodes),
@@ -1,10 +1,54 @@
 #ifndef _SWAY_IPC_JSON_H
 #define _SWAY_IPC_JSON_H
 #include <json.h>
+#include "ipc-json-buffer.h"
 #include "sway/output.h"
+#include "sway/stats.h"
 #include "sway/tree/container.h"
 #include "sway/input/input-manager.h"
 
+// IDs of the __i3 output and __i3_scratch workspace holding the scratchpad
+extern const int i3_output_id;
+extern const int i3_scratch_id;
+
+const char *ipc_json_node_type_description(enum sway_node_type node_type);
+const char *ipc_json_layout_description(enum sway_container_layout l);
+
+/**
+ * The node's "rect" as reported in the tree, excluding title bars.
+ */
+void ipc_json_get_node_rect(struct sway_node *node, struct wlr_box *box);
+
+/**
+ * Field projection for get_* replies. Fields are given as dot-separated paths
+ * such as "window_properties.class"; everything else is left out of the
+ * descriptions, and not computed at all where that is expensive.
+ */
+struct ipc_json_fields;
+
+struct ipc_json_fields *ipc_json_fields_parse(json_object *array, char **error);
+void ipc_json_fields_destroy(struct ipc_json_fields *fields);
+
+/**
+ * Add a path to a restricted set of fields. Does nothing if all fields are
+ * included.
+ */
+void ipc_json_fields_add(struct ipc_json_fields *fields, const char *path);
+
+/**
+ * Only include the given fields in the descriptions built until the next
+ * call. Passing NULL includes all fields again.
+ */
+void ipc_json_set_fields(struct ipc_json_fields *fields);
+
+bool ipc_json_field_wanted(const char *name);
+
+/**
+ * Remove all fields that weren't requested from an object, or from each
+ * object of an array.
+ */
+void ipc_json_project(json_object *object);
+
 json_object *ipc_json_get_version(void);
 
 json_object *ipc_json_get_binding_mode(void);
@@ -15,6 +59,20 @@ json_object *ipc_json_describe_node(struct sway_node *node);
 json_object *ipc_json_describe_node_recursive(struct sway_node *node);
 json_object *ipc_json_describe_input(struct sway_input_device *device);
 json_object *ipc_json_describe_seat(struct sway_seat *seat);
+json_object *ipc_json_describe_histogram(const struct sway_histogram *histogram);
+/**
+ * Describe the counters and timings kept outside of the IPC server, for the
+ * get_stats reply.
+ */
+json_object *ipc_json_describe_server_stats(void);
 json_object *ipc_json_describe_bar_config(struct bar_config *bar);
 
+/**
+ * Write the same JSON as ipc_json_describe_node_recursive, without building
+ * the whole subtree as json-c objects first. If extra_key is set, extra_value
+ * is added to the node's object under it, after all other keys.
+ */
+void ipc_json_write_node_recursive(struct ipc_json_buffer *buf,
+	struct sway_node *node, const char *extra_key, json_object *extra_value);
+
 #endif
@@ -23,4 +23,15 @@ void ipc_event_binding(struct sway_binding *binding);
 void ipc_event_input(const char *change, struct sway_input_device *device);
 void ipc_event_output(void);
 
+/**
+ * Send a tree event once the current events have been handled. Called
+ * whenever the tree might have changed.
+ */
+void ipc_event_tree_schedule(void);
+
+/**
+ * Send a tree event for any changes right away.
+ */
+void ipc_event_tree_flush(void);
+
 #endif
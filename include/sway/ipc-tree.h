@@ -0,0 +1,34 @@
+#ifndef _SWAY_IPC_TREE_H
+#define _SWAY_IPC_TREE_H
+#include <json.h>
+#include <stdint.h>
+
+/**
+ * Incremental tree events.
+ *
+ * A snapshot of the pending tree is kept in get_tree order. Each call to
+ * ipc_tree_diff walks the tree again, compares it against the snapshot by node
+ * ID and describes the differences as node-level changes. Clients mirror the
+ * tree by requesting a get_tree snapshot tagged with the sequence number and
+ * applying every tree event with a higher sequence number on top of it.
+ */
+
+/**
+ * Compare the tree against the previous snapshot and return a tree event
+ * object, or NULL if nothing changed. If there is no previous snapshot, one is
+ * taken and NULL is returned. The sequence number is incremented for every
+ * returned event.
+ */
+json_object *ipc_tree_diff(void);
+
+/**
+ * The sequence number of the most recent tree event.
+ */
+uint64_t ipc_tree_sequence(void);
+
+/**
+ * Drop the snapshot. Used when nobody is subscribed to tree events anymore.
+ */
+void ipc_tree_reset(void);
+
+#endif
@@ -1,5 +1,6 @@
 #ifndef _SWAY_OUTPUT_H
 #define _SWAY_OUTPUT_H
+#include <stdint.h>
 #include <time.h>
 #include <unistd.h>
 #include <wayland-server-core.h>
@@ -72,6 +73,12 @@ struct sway_output {
 
 	bool allow_tearing;
 	bool hdr;
+
+	// Counters for output_configure_scene, exposed through get_outputs
+	struct {
+		uint64_t nodes_visited;
+		uint64_t subtrees_skipped;
+	} configure_stats;
 };
 
 struct sway_output_non_desktop {
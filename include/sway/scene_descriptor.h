@@ -5,10 +5,15 @@
  *
  * This object lets us store values that represent these modes of operation
  * and keep track of what object is being represented.
+ *
+ * All descriptors of a scene node live in a single record that the node's
+ * data pointer refers to, so sway reserves wlr_scene_node.data for it.
  */
 #ifndef _SWAY_SCENE_DESCRIPTOR_H
 #define _SWAY_SCENE_DESCRIPTOR_H
+#include <stdint.h>
 #include <wlr/types/wlr_scene.h>
+#include <wlr/util/addon.h>
 
 enum sway_scene_descriptor_type {
 	SWAY_SCENE_DESC_BUFFER_TIMER,
@@ -19,13 +24,33 @@ enum sway_scene_descriptor_type {
 	SWAY_SCENE_DESC_XWAYLAND_UNMANAGED,
 	SWAY_SCENE_DESC_POPUP,
 	SWAY_SCENE_DESC_DRAG_ICON,
+	SWAY_SCENE_DESC_COUNT,
+};
+
+struct sway_scene_descriptor {
+	uint32_t types; // bitmask of 1 << enum sway_scene_descriptor_type
+	void *data[SWAY_SCENE_DESC_COUNT];
+
+	struct wlr_scene_node *node;
+	struct wlr_addon addon; // frees the record along with the node
 };
 
 bool scene_descriptor_assign(struct wlr_scene_node *node,
 	enum sway_scene_descriptor_type type, void *data);
 
-void *scene_descriptor_try_get(struct wlr_scene_node *node,
-	enum sway_scene_descriptor_type type);
+/**
+ * Get all descriptors of a node at once, or NULL if it has none.
+ */
+static inline struct sway_scene_descriptor *scene_descriptor_get(
+		struct wlr_scene_node *node) {
+	return node->data;
+}
+
+static inline void *scene_descriptor_try_get(struct wlr_scene_node *node,
+		enum sway_scene_descriptor_type type) {
+	struct sway_scene_descriptor *desc = scene_descriptor_get(node);
+	return desc ? desc->data[type] : NULL;
+}
 
 void scene_descriptor_destroy(struct wlr_scene_node *node,
 	enum sway_scene_descriptor_type type);
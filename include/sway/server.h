@@ -1,10 +1,12 @@
 #ifndef _SWAY_SERVER_H
 #define _SWAY_SERVER_H
 #include <stdbool.h>
+#include <stdint.h>
 #include <wayland-server-core.h>
 #include "config.h"
 #include "list.h"
 #include "sway/desktop/idle_inhibit_v1.h"
+#include "sway/stats.h"
 #if WLR_HAS_XWAYLAND
 #include "sway/xwayland.h"
 #endif
@@ -150,7 +152,41 @@ struct sway_server {
 	// the pending transaction.
 	list_t *dirty_nodes;
 
+	// Instructions and state lists of destroyed transactions, recycled by
+	// later transactions instead of being freed and allocated again
+	list_t *txn_instruction_pool; // struct sway_transaction_instruction *
+	list_t *txn_list_pool; // list_t *
+	struct {
+		uint64_t instructions_allocated;
+		uint64_t instructions_reused;
+		uint64_t lists_allocated;
+		uint64_t lists_reused;
+	} txn_pool_stats;
+	struct {
+		uint64_t containers_arranged;
+		uint64_t containers_dirtied;
+	} arrange_stats;
+
 	struct wl_event_source *delayed_modeset;
+
+	// Number of client title changes merged into a later title update
+	uint64_t title_updates_coalesced;
+	// Number of text node rasterizations saved by batching property changes
+	uint64_t text_renders_coalesced;
+	struct {
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t evictions;
+		size_t entries;
+		size_t bytes;
+	} text_cache_stats;
+
+	// Timings reported by the get_stats IPC message
+	struct {
+		struct sway_histogram commands; // execute_command and compiled lists
+		struct sway_histogram transaction_commit;
+		struct sway_histogram transaction_apply;
+	} timings;
 };
 
 extern struct sway_server server;
@@ -0,0 +1,37 @@
+#ifndef _SWAY_STATS_H
+#define _SWAY_STATS_H
+#include <stdint.h>
+#include <time.h>
+
+#define SWAY_HISTOGRAM_BUCKETS 12
+
+/**
+ * Upper bounds of the histogram buckets, in microseconds. The last bucket
+ * counts everything above the last bound.
+ */
+extern const uint64_t sway_histogram_bounds_usec[SWAY_HISTOGRAM_BUCKETS - 1];
+
+/**
+ * A latency histogram, reported by the get_stats IPC message.
+ */
+struct sway_histogram {
+	uint64_t count;
+	uint64_t total_usec;
+	uint64_t max_usec;
+	uint64_t buckets[SWAY_HISTOGRAM_BUCKETS];
+};
+
+void histogram_add(struct sway_histogram *histogram, uint64_t usec);
+
+/**
+ * Microseconds elapsed since start, which was taken from CLOCK_MONOTONIC.
+ */
+uint64_t stats_elapsed_usec(const struct timespec *start);
+
+/**
+ * Add the time elapsed since start.
+ */
+void histogram_add_since(struct sway_histogram *histogram,
+	const struct timespec *start);
+
+#endif
@@ -25,4 +25,16 @@ void sway_text_node_set_max_width(struct sway_text_node *node, int max_width);
 
 void sway_text_node_set_background(struct sway_text_node *node, float background[4]);
 
+/**
+ * Rasterize the text nodes changed since the last flush. Changes are batched
+ * and flushed automatically when the event loop goes idle, and before an
+ * output is rendered.
+ */
+void sway_text_node_flush(void);
+
+/**
+ * Release the rendered text buffers shared between text nodes.
+ */
+void sway_text_node_cache_finish(void);
+
 #endif
@@ -2,6 +2,7 @@
 #define _SWAY_NODE_H
 #include <wayland-server-core.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <wlr/types/wlr_scene.h>
 #include "list.h"
 
@@ -13,6 +14,7 @@ struct sway_output;
 struct sway_workspace;
 struct sway_container;
 struct sway_transaction_instruction;
+struct sway_seat;
 struct wlr_box;
 
 enum sway_node_type {
@@ -22,6 +24,18 @@ enum sway_node_type {
 	N_CONTAINER,
 };
 
+/**
+ * The cached answer of a seat focus query for a node. It is only valid for
+ * the seat that it was computed for, and only until the tree structure or the
+ * set of nodes in any focus stack changes.
+ */
+struct sway_focus_cache {
+	struct sway_seat *seat;
+	uint64_t tree_generation;
+	uint64_t focus_generation;
+	struct sway_node *node;
+};
+
 struct sway_node {
 	enum sway_node_type type;
 	union {
@@ -38,6 +52,8 @@ struct sway_node {
 	size_t id;
 
 	struct sway_transaction_instruction *instruction;
+	// The node's instruction in the pending (not yet committed) transaction
+	struct sway_transaction_instruction *pending_instruction;
 	size_t ntxnrefs;
 	bool destroying;
 
@@ -45,6 +61,10 @@ struct sway_node {
 	// the current.
 	bool dirty;
 
+	// See seat_get_focus_inactive and seat_get_active_tiling_child
+	struct sway_focus_cache focus_inactive;
+	struct sway_focus_cache active_tiling_child;
+
 	struct {
 		struct wl_signal destroy;
 	} events;
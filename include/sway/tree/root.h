@@ -12,6 +12,23 @@
 
 extern struct sway_root *root;
 
+struct sway_container_index_slot {
+	uint32_t hash;
+	const char *mark; // owned by the container, NULL when keyed by ID
+	size_t id;
+	struct sway_container *con; // NULL for unused slots
+};
+
+/**
+ * Open addressing hash table of containers, keyed either by node ID or by
+ * mark. Containers are removed when they begin to be destroyed.
+ */
+struct sway_container_index {
+	struct sway_container_index_slot *slots;
+	size_t capacity; // power of two
+	size_t length;
+};
+
 struct sway_root {
 	struct sway_node node;
 	struct wlr_output_layout *output_layout;
@@ -69,6 +86,13 @@ struct sway_root {
 
 	struct sway_container *fullscreen_global;
 
+	struct sway_container_index containers_by_id;
+	struct sway_container_index containers_by_mark;
+
+	// Incremented whenever nodes are attached to or detached from the pending
+	// tree, or global fullscreen changes
+	uint64_t tree_generation;
+
 	struct {
 		struct wl_signal new_node;
 	} events;
@@ -119,4 +143,27 @@ struct sway_container *root_find_container(
 
 void root_get_box(struct sway_root *root, struct wlr_box *box);
 
+/**
+ * Add a container to the node ID index, or remove it along with its marks.
+ */
+void root_index_container(struct sway_container *con);
+
+void root_unindex_container(struct sway_container *con);
+
+/**
+ * Add a mark of a container to the mark index, or remove it. The mark string
+ * must be owned by the container and stay unchanged while it is indexed.
+ */
+void root_index_mark(struct sway_container *con, const char *mark);
+
+void root_unindex_mark(struct sway_container *con, const char *mark);
+
+struct sway_container *root_find_container_by_id(size_t id);
+
+struct sway_container *root_find_container_by_mark(const char *mark);
+
+void root_for_each_mark(
+		void (*f)(const char *mark, struct sway_container *con, void *data),
+		void *data);
+
 #endif
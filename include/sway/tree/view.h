@@ -36,6 +36,29 @@ enum sway_view_prop {
 #endif
 };
 
+/**
+ * Groups of view properties which criteria can depend on. Each has a serial in
+ * the view which is bumped whenever one of its properties changes.
+ */
+enum view_criteria_dep {
+	CRITERIA_DEP_TITLE,
+	CRITERIA_DEP_APP_ID,
+	CRITERIA_DEP_TAG,
+	CRITERIA_DEP_X11, // class, instance, window role and window type
+	CRITERIA_DEP_MARKS,
+	CRITERIA_DEP_COUNT,
+};
+
+/**
+ * The cached result of matching a criteria against a view.
+ */
+struct view_criteria_result {
+	uint32_t stamp; // sum of the serials the criteria depends on
+	bool valid;
+	bool matched;
+	bool executed; // for_window commands have been run on the view
+};
+
 enum sway_view_tearing_mode {
 	TEARING_OVERRIDE_FALSE,
 	TEARING_OVERRIDE_TRUE,
@@ -93,6 +116,12 @@ struct sway_view {
 	bool allow_request_urgent;
 	struct wl_event_source *urgent_timer;
 
+	// Title changes are applied at most once per title update interval.
+	// Changes arriving in between are merged and applied by title_timer.
+	struct wl_event_source *title_timer;
+	struct timespec title_updated;
+	bool title_update_pending;
+
 	// The geometry for whatever the client is committing, regardless of
 	// transaction state. Updated on every commit.
 	struct wlr_box geometry;
@@ -107,7 +136,12 @@ struct sway_view {
 
 	bool destroying;
 
-	list_t *executed_criteria; // struct criteria *
+	// Serials of the property groups in enum view_criteria_dep
+	uint32_t criteria_serials[CRITERIA_DEP_COUNT];
+	// Cached criteria results, indexed by position in config->criteria
+	struct view_criteria_result *criteria_results;
+	int criteria_results_len;
+	uint32_t criteria_results_generation; // config->criteria_generation
 
 	union {
 		struct wlr_xdg_toplevel *wlr_xdg_toplevel;
@@ -339,6 +373,16 @@ void view_update_app_id(struct sway_view *view);
  */
 void view_update_title(struct sway_view *view, bool force);
 
+/**
+ * Handle a title change requested by the client. The title and any criteria
+ * are updated right away unless the title changed less than one update
+ * interval ago, in which case the update is deferred and merged with any other
+ * changes until the interval has passed.
+ *
+ * The caller is expected to commit dirty nodes afterwards.
+ */
+void view_request_title_update(struct sway_view *view);
+
 /**
  * Run any criteria that match the view and haven't been run on this view
  * before.
@@ -51,6 +51,10 @@ struct sway_workspace {
 	list_t *output_priority;
 	bool urgent;
 
+	// See seat_get_focus_inactive_tiling and seat_get_focus_inactive_floating
+	struct sway_focus_cache focus_inactive_tiling;
+	struct sway_focus_cache focus_inactive_floating;
+
 	struct sway_workspace_state current;
 	struct wlr_ext_workspace_handle_v1 *ext_workspace; // Always set.
 };
@@ -77,6 +77,26 @@ struct swaybar_output {
 	bool dirty;
 	bool frame_scheduled;
 
+	// Rasterized pieces of the bar and measured text, reused for as long as
+	// their content doesn't change
+	struct wl_list render_pieces; // render_piece::link
+	struct wl_list text_sizes; // text_size::link
+
+	// The last rendered frame and the pieces it was composed of, compared
+	// against the next frame's to find the regions which need to be redrawn,
+	// copied into a buffer and damaged
+	cairo_surface_t *last_frame;
+	struct render_segment *last_segments;
+	int last_segments_len;
+	uint32_t last_background;
+	bool *last_damage; // per column tile of last_frame
+	uint32_t frame_serial;
+	// The frame each buffer was last drawn with
+	struct {
+		struct wl_buffer *buffer;
+		uint32_t frame_serial;
+	} buffer_frames[2];
+
 	uint32_t output_height, output_width, output_x, output_y;
 };
 
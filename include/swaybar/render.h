@@ -5,4 +5,10 @@ struct swaybar_output;
 
 void render_frame(struct swaybar_output *output);
 
+/**
+ * Forget the previous frame and the pieces it was drawn from, so the next one
+ * is drawn and damaged in full.
+ */
+void render_reset_damage(struct swaybar_output *output);
+
 #endif
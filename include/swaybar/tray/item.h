@@ -31,6 +31,7 @@ struct swaybar_sni {
 	int min_size;
 	int max_size;
 	int target_size;
+	uint32_t icon_serial; // changes whenever icon does
 
 	// dbus properties
 	char *watcher_id;
@@ -54,5 +55,10 @@ struct swaybar_sni *create_sni(char *id, struct swaybar_tray *tray);
 void destroy_sni(struct swaybar_sni *sni);
 uint32_t render_sni(cairo_t *cairo, struct swaybar_output *output, double *x,
 		struct swaybar_sni *sni);
+/**
+ * Adds the hotspot of an item drawn by render_sni, moving x past it.
+ */
+void add_sni_hotspot(struct swaybar_output *output, struct swaybar_sni *sni,
+		double *x);
 
 #endif
@@ -38,5 +38,15 @@ struct swaybar_tray *create_tray(struct swaybar *bar);
 void destroy_tray(struct swaybar_tray *tray);
 void tray_in(int fd, short mask, void *data);
 uint32_t render_tray(cairo_t *cairo, struct swaybar_output *output, double *x);
+/**
+ * Adds the hotspots of the tray drawn by render_tray, starting at x.
+ */
+void add_tray_hotspots(struct swaybar_output *output, double x);
+/**
+ * Describes everything render_tray draws on the output, so the rendered tray
+ * can be reused while the description stays the same. Returns NULL if the
+ * tray isn't shown on the output.
+ */
+char *describe_tray(struct swaybar_output *output);
 
 #endif
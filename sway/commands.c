@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <time.h>
 #include <stdio.h>
 #include <json.h>
 #include "sway/commands.h"
@@ -10,6 +11,7 @@
 #include "sway/criteria.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
+#include "sway/server.h"
 #include "sway/tree/view.h"
 #include "stringop.h"
 #include "log.h"
@@ -74,6 +76,7 @@ static const struct cmd_handler handlers[] = {
 	{ "gaps", cmd_gaps },
 	{ "hide_edge_borders", cmd_hide_edge_borders },
 	{ "input", cmd_input },
+	{ "ipc_client_backlog", cmd_ipc_client_backlog },
 	{ "mode", cmd_mode },
 	{ "mouse_warping", cmd_mouse_warping },
 	{ "new_float", cmd_new_float },
@@ -202,6 +205,54 @@ static void set_config_node(struct sway_node *node, bool node_overridden) {
 	}
 }
 
+/**
+ * Runs a handler on the context node, or on each of the containers if
+ * criteria were given. Returns false if the command was invalid and the
+ * remaining commands must not be run.
+ */
+static bool run_command_handler(const struct cmd_handler *handler,
+		int argc, char **argv, bool using_criteria, list_t *containers,
+		struct sway_seat *seat, struct sway_container *con, list_t *res_list) {
+	if (!using_criteria) {
+		if (con) {
+			set_config_node(&con->node, true);
+		} else {
+			set_config_node(seat_get_focus_inactive(seat, &root->node),
+					false);
+		}
+		struct cmd_results *res = handler->handle(argc-1, argv+1);
+		list_add(res_list, res);
+		return res->status != CMD_INVALID;
+	} else if (containers->length == 0) {
+		list_add(res_list,
+				cmd_results_new(CMD_FAILURE, "No matching node."));
+		return true;
+	}
+
+	struct cmd_results *fail_res = NULL;
+	for (int i = 0; i < containers->length; ++i) {
+		struct sway_container *container = containers->items[i];
+		set_config_node(&container->node, true);
+		struct cmd_results *res = handler->handle(argc-1, argv+1);
+		if (res->status == CMD_SUCCESS) {
+			free_cmd_results(res);
+		} else {
+			// last failure will take precedence
+			if (fail_res) {
+				free_cmd_results(fail_res);
+			}
+			fail_res = res;
+			if (res->status == CMD_INVALID) {
+				list_add(res_list, fail_res);
+				return false;
+			}
+		}
+	}
+	list_add(res_list,
+			fail_res ? fail_res : cmd_results_new(CMD_SUCCESS, NULL));
+	return true;
+}
+
 list_t *execute_command(char *_exec, struct sway_seat *seat,
 		struct sway_container *con) {
 	char *cmd;
@@ -217,6 +268,9 @@ list_t *execute_command(char *_exec, struct sway_seat *seat,
 		}
 	}
 
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
 	char *exec = strdup(_exec);
 	char *head = exec;
 	list_t *res_list = create_list();
@@ -284,52 +338,233 @@ list_t *execute_command(char *_exec, struct sway_seat *seat,
 			argv[i] = do_var_replacement(argv[i]);
 		}
 
+		bool ok = run_command_handler(handler, argc, argv, using_criteria,
+			containers, seat, con, res_list);
+		free_argv(argc, argv);
+		if (!ok) {
+			goto cleanup;
+		}
+	} while(head);
+cleanup:
+	free(exec);
+	list_free(containers);
+	histogram_add_since(&server.timings.commands, &start);
+	return res_list;
+}
 
-		if (!using_criteria) {
-			if (con) {
-				set_config_node(&con->node, true);
-			} else {
-				set_config_node(seat_get_focus_inactive(seat, &root->node),
-						false);
-			}
-			struct cmd_results *res = handler->handle(argc-1, argv+1);
-			list_add(res_list, res);
-			if (res->status == CMD_INVALID) {
-				free_argv(argc, argv);
-				goto cleanup;
+struct compiled_command {
+	char *text; // for logging
+	const struct cmd_handler *handler;
+	int argc;
+	char **argv; // quotes stripped and variables replaced
+	// Criteria of the enclosing ';' separated group or NULL, owned by the list
+	struct criteria *criteria;
+	bool first_in_group;
+};
+
+struct compiled_command_list {
+	int refs;
+	// Value of config->symbols_serial the arguments were substituted with
+	int symbols_serial;
+	// False if the commands could not be compiled and need to go through
+	// execute_command, which reports the error
+	bool valid;
+	list_t *commands; // struct compiled_command
+	list_t *criteria; // struct criteria
+};
+
+static void compiled_command_list_unref(struct compiled_command_list *compiled) {
+	if (!compiled || --compiled->refs > 0) {
+		return;
+	}
+	for (int i = 0; i < compiled->commands->length; ++i) {
+		struct compiled_command *command = compiled->commands->items[i];
+		free(command->text);
+		free_argv(command->argc, command->argv);
+		free(command);
+	}
+	list_free(compiled->commands);
+	for (int i = 0; i < compiled->criteria->length; ++i) {
+		criteria_destroy(compiled->criteria->items[i]);
+	}
+	list_free(compiled->criteria);
+	free(compiled);
+}
+
+void compiled_command_list_destroy(struct compiled_command_list *compiled) {
+	compiled_command_list_unref(compiled);
+}
+
+/**
+ * Splits the command string the same way execute_command does. On failure
+ * the returned list is marked invalid.
+ */
+static struct compiled_command_list *compile_command_list(const char *_exec) {
+	struct compiled_command_list *compiled = calloc(1, sizeof(*compiled));
+	if (!compiled) {
+		return NULL;
+	}
+	compiled->refs = 1;
+	compiled->symbols_serial = config->symbols_serial;
+	compiled->commands = create_list();
+	compiled->criteria = create_list();
+
+	char *exec = strdup(_exec);
+	if (!exec) {
+		compiled_command_list_unref(compiled);
+		return NULL;
+	}
+
+	char *head = exec;
+	char matched_delim = ';';
+	struct criteria *criteria = NULL;
+	bool first_in_group = true;
+	do {
+		for (; isspace(*head); ++head) {}
+		if (matched_delim == ';') {
+			criteria = NULL;
+			first_in_group = true;
+			if (*head == '[') {
+				char *error = NULL;
+				criteria = criteria_parse(head, &error);
+				if (!criteria) {
+					free(error);
+					goto cleanup;
+				}
+				list_add(compiled->criteria, criteria);
+				// con_id=__focused__ is resolved when parsing
+				if (strstr(criteria->raw, "__focused__")) {
+					goto cleanup;
+				}
+				head += strlen(criteria->raw);
+				for (; isspace(*head); ++head) {}
 			}
-		} else if (containers->length == 0) {
-			list_add(res_list,
-					cmd_results_new(CMD_FAILURE, "No matching node."));
-		} else {
-			struct cmd_results *fail_res = NULL;
-			for (int i = 0; i < containers->length; ++i) {
-				struct sway_container *container = containers->items[i];
-				set_config_node(&container->node, true);
-				struct cmd_results *res = handler->handle(argc-1, argv+1);
-				if (res->status == CMD_SUCCESS) {
-					free_cmd_results(res);
-				} else {
-					// last failure will take precedence
-					if (fail_res) {
-						free_cmd_results(fail_res);
-					}
-					fail_res = res;
-					if (res->status == CMD_INVALID) {
-						list_add(res_list, fail_res);
-						free_argv(argc, argv);
-						goto cleanup;
-					}
+		}
+		char *cmd = argsep(&head, ";,", &matched_delim);
+		for (; isspace(*cmd); ++cmd) {}
+
+		if (strcmp(cmd, "") == 0) {
+			continue;
+		}
+		int argc;
+		char **argv = split_args(cmd, &argc);
+		if (strcmp(argv[0], "exec") != 0 &&
+				strcmp(argv[0], "exec_always") != 0 &&
+				strcmp(argv[0], "mode") != 0) {
+			for (int i = 1; i < argc; ++i) {
+				if (*argv[i] == '\"' || *argv[i] == '\'') {
+					strip_quotes(argv[i]);
 				}
 			}
-			list_add(res_list,
-					fail_res ? fail_res : cmd_results_new(CMD_SUCCESS, NULL));
 		}
-		free_argv(argc, argv);
-	} while(head);
+		const struct cmd_handler *handler = find_core_handler(argv[0]);
+		if (!handler) {
+			free_argv(argc, argv);
+			goto cleanup;
+		}
+		for (int i = handler->handle == cmd_set ? 2 : 1; i < argc; ++i) {
+			argv[i] = do_var_replacement(argv[i]);
+		}
+
+		struct compiled_command *command = calloc(1, sizeof(*command));
+		if (!command) {
+			free_argv(argc, argv);
+			goto cleanup;
+		}
+		command->text = strdup(cmd);
+		command->handler = handler;
+		command->argc = argc;
+		command->argv = argv;
+		command->criteria = criteria;
+		command->first_in_group = first_in_group;
+		first_in_group = false;
+		list_add(compiled->commands, command);
+	} while (head);
+
+	compiled->valid = true;
+
 cleanup:
 	free(exec);
+	return compiled;
+}
+
+static char **copy_argv(int argc, char **argv) {
+	char **copy = calloc(argc + 1, sizeof(char *));
+	if (!copy) {
+		return NULL;
+	}
+	for (int i = 0; i < argc; ++i) {
+		copy[i] = strdup(argv[i]);
+	}
+	return copy;
+}
+
+list_t *execute_compiled_command(struct compiled_command_list **compiled_ptr,
+		char *command, struct sway_seat *seat, struct sway_container *con) {
+	// Handlers are looked up differently while the config is being read
+	if (config->reading || !config->active) {
+		return execute_command(command, seat, con);
+	}
+
+	// The fallbacks to execute_command record their own timing
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	struct compiled_command_list *compiled = *compiled_ptr;
+	if (compiled && compiled->symbols_serial != config->symbols_serial) {
+		compiled_command_list_unref(compiled);
+		compiled = *compiled_ptr = NULL;
+	}
+	if (!compiled) {
+		compiled = *compiled_ptr = compile_command_list(command);
+	}
+	if (!compiled || !compiled->valid) {
+		return execute_command(command, seat, con);
+	}
+
+	if (seat == NULL) {
+		seat = input_manager_get_default_seat();
+		if (!sway_assert(seat, "could not find a seat to run the command on")) {
+			return NULL;
+		}
+	}
+
+	list_t *res_list = create_list();
+	if (!res_list) {
+		return NULL;
+	}
+
+	// The commands may free their owner, e.g. by unbinding the binding
+	compiled->refs++;
+	config->handler_context.seat = seat;
+
+	list_t *containers = NULL;
+	for (int i = 0; i < compiled->commands->length; ++i) {
+		struct compiled_command *cmd = compiled->commands->items[i];
+		if (cmd->first_in_group && cmd->criteria) {
+			list_free(containers);
+			containers = criteria_get_containers(cmd->criteria);
+		}
+		sway_log(SWAY_INFO, "Handling command '%s'", cmd->text);
+
+		// Handlers are free to modify their arguments
+		char **argv = copy_argv(cmd->argc, cmd->argv);
+		if (!argv) {
+			list_add(res_list, cmd_results_new(CMD_FAILURE,
+					"Unable to allocate command arguments"));
+			break;
+		}
+		bool ok = run_command_handler(cmd->handler, cmd->argc, argv,
+			cmd->criteria != NULL, containers, seat, con, res_list);
+		free_argv(cmd->argc, argv);
+		if (!ok) {
+			break;
+		}
+	}
+
 	list_free(containers);
+	compiled_command_list_unref(compiled);
+	histogram_add_since(&server.timings.commands, &start);
 	return res_list;
 }
 
@@ -54,7 +54,7 @@ struct cmd_results *cmd_assign(int argc, char **argv) {
 
 	criteria->target = join_args(argv, argc);
 
-	list_add(config->criteria, criteria);
+	criteria_add(criteria);
 	sway_log(SWAY_DEBUG, "assign: '%s' -> '%s' added", criteria->raw,
 			criteria->target);
 
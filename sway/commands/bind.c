@@ -27,6 +27,7 @@ void free_sway_binding(struct sway_binding *binding) {
 	list_free_items_and_destroy(binding->syms);
 	free(binding->input);
 	free(binding->command);
+	compiled_command_list_destroy(binding->compiled_command);
 	free(binding);
 }
 
@@ -475,8 +476,10 @@ static struct cmd_results *cmd_bindsym_or_bindcode(int argc, char **argv,
 	list_t *mode_bindings;
 	if (binding->type == BINDING_KEYCODE) {
 		mode_bindings = config->current_mode->keycode_bindings;
+		sway_mode_reset_binding_index(config->current_mode);
 	} else if (binding->type == BINDING_KEYSYM) {
 		mode_bindings = config->current_mode->keysym_bindings;
+		sway_mode_reset_binding_index(config->current_mode);
 	} else {
 		mode_bindings = config->current_mode->mouse_bindings;
 	}
@@ -614,6 +617,7 @@ void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding)
 		}
 		memcpy(deferred, binding, sizeof(struct sway_binding));
 		deferred->command = binding->command ? strdup(binding->command) : NULL;
+		deferred->compiled_command = NULL;
 		list_add(seat->deferred_bindings, deferred);
 		return;
 	}
@@ -632,7 +636,14 @@ void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding)
 		}
 	}
 
-	list_t *res_list = execute_command(binding->command, seat, con);
+	list_t *res_list;
+	if (binding->type == BINDING_SWITCH || binding->type == BINDING_GESTURE) {
+		// Dummy bindings don't outlive the call, don't compile their command
+		res_list = execute_command(binding->command, seat, con);
+	} else {
+		res_list = execute_compiled_command(&binding->compiled_command,
+			binding->command, seat, con);
+	}
 	bool success = true;
 	for (int i = 0; i < res_list->length; ++i) {
 		struct cmd_results *results = res_list->items[i];
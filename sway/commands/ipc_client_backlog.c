@@ -0,0 +1,42 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sway/commands.h"
+#include "sway/config.h"
+
+// ipc_client_backlog <size>[k|M]|none
+struct cmd_results *cmd_ipc_client_backlog(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "ipc_client_backlog", EXPECTED_EQUAL_TO, 1))) {
+		return error;
+	}
+
+	if (strcmp(argv[0], "none") == 0) {
+		config->ipc_client_backlog = 0;
+		return cmd_results_new(CMD_SUCCESS, NULL);
+	}
+
+	char *inv;
+	errno = 0;
+	long long value = strtoll(argv[0], &inv, 10);
+	if (inv == argv[0] || errno == ERANGE || value <= 0) {
+		return cmd_results_new(CMD_INVALID, "Invalid backlog size specified");
+	}
+	unsigned long long multiplier = 1;
+	if (strcmp(inv, "k") == 0 || strcmp(inv, "K") == 0) {
+		multiplier = 1000;
+	} else if (strcmp(inv, "M") == 0) {
+		multiplier = 1000 * 1000;
+	} else if (*inv != '\0') {
+		return cmd_results_new(CMD_INVALID,
+			"Expected 'ipc_client_backlog <size>[k|M]|none'");
+	}
+	if ((unsigned long long)value > SIZE_MAX / multiplier) {
+		return cmd_results_new(CMD_INVALID, "Backlog size is too large");
+	}
+
+	config->ipc_client_backlog = (size_t)value * multiplier;
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
@@ -28,7 +28,7 @@ struct cmd_results *cmd_no_focus(int argc, char **argv) {
 		return cmd_results_new(CMD_SUCCESS, NULL);
 	}
 
-	list_add(config->criteria, criteria);
+	criteria_add(criteria);
 
 	return cmd_results_new(CMD_SUCCESS, NULL);
 }
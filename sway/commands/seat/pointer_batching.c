@@ -0,0 +1,20 @@
+#include "sway/config.h"
+#include "sway/commands.h"
+#include "util.h"
+
+// pointer_batching enable|disable
+struct cmd_results *seat_cmd_pointer_batching(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "pointer_batching", EXPECTED_EQUAL_TO, 1))) {
+		return error;
+	}
+	if (!config->handler_context.seat_config) {
+		return cmd_results_new(CMD_FAILURE, "No seat defined");
+	}
+
+	config->handler_context.seat_config->pointer_batching =
+		parse_boolean(argv[0], false) ?
+		POINTER_BATCHING_ENABLE : POINTER_BATCHING_DISABLE;
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
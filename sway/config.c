@@ -17,6 +17,7 @@
 #include <linux/input-event-codes.h>
 #include <wlr/types/wlr_output.h>
 #include "sway/input/input-manager.h"
+#include "sway/input/keyboard.h"
 #include "sway/input/seat.h"
 #include "sway/input/switch.h"
 #include "sway/commands.h"
@@ -67,6 +68,7 @@ static void free_mode(struct sway_mode *mode) {
 		return;
 	}
 	free(mode->name);
+	sway_mode_reset_binding_index(mode);
 	if (mode->keysym_bindings) {
 		for (int i = 0; i < mode->keysym_bindings->length; i++) {
 			free_sway_binding(mode->keysym_bindings->items[i]);
@@ -160,6 +162,7 @@ void free_config(struct sway_config *config) {
 		}
 		list_free(config->seat_configs);
 	}
+	criteria_index_destroy(config->criteria_index);
 	if (config->criteria) {
 		for (int i = 0; i < config->criteria->length; ++i) {
 			criteria_destroy(config->criteria->items[i]);
@@ -220,6 +223,8 @@ static void config_defaults(struct sway_config *config) {
 	if (!(config->bars = create_list())) goto cleanup;
 	if (!(config->workspace_configs = create_list())) goto cleanup;
 	if (!(config->criteria = create_list())) goto cleanup;
+	static uint32_t criteria_generation = 0;
+	config->criteria_generation = ++criteria_generation;
 	if (!(config->no_focus = create_list())) goto cleanup;
 	if (!(config->seat_configs = create_list())) goto cleanup;
 	if (!(config->output_configs = create_list())) goto cleanup;
@@ -229,7 +234,7 @@ static void config_defaults(struct sway_config *config) {
 
 	if (!(config->cmd_queue = create_list())) goto cleanup;
 
-	if (!(config->current_mode = malloc(sizeof(struct sway_mode))))
+	if (!(config->current_mode = calloc(1, sizeof(struct sway_mode))))
 		goto cleanup;
 	if (!(config->current_mode->name = malloc(sizeof("default")))) goto cleanup;
 	strcpy(config->current_mode->name, "default");
@@ -283,6 +288,7 @@ static void config_defaults(struct sway_config *config) {
 	config->tiling_drag = true;
 	config->tiling_drag_threshold = 9;
 	config->primary_selection = true;
+	config->ipc_client_backlog = 4000000;
 
 	config->smart_gaps = SMART_GAPS_OFF;
 	config->gaps_inner = 0;
@@ -1006,6 +1012,7 @@ void translate_keysyms(struct input_config *input_config) {
 
 		mode->keysym_bindings = bindsyms;
 		mode->keycode_bindings = bindcodes;
+		sway_mode_reset_binding_index(mode);
 	}
 
 	sway_log(SWAY_DEBUG, "Translated keysyms using config for device '%s'",
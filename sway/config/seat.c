@@ -32,6 +32,7 @@ struct seat_config *new_seat_config(const char* name) {
 	seat->allow_constrain = CONSTRAIN_DEFAULT;
 	seat->shortcuts_inhibit = SHORTCUTS_INHIBIT_DEFAULT;
 	seat->keyboard_grouping = KEYBOARD_GROUP_DEFAULT;
+	seat->pointer_batching = POINTER_BATCHING_DEFAULT;
 	seat->xcursor_theme.name = NULL;
 	seat->xcursor_theme.size = 24;
 
@@ -166,6 +167,10 @@ void merge_seat_config(struct seat_config *dest, struct seat_config *source) {
 		dest->keyboard_grouping = source->keyboard_grouping;
 	}
 
+	if (source->pointer_batching != POINTER_BATCHING_DEFAULT) {
+		dest->pointer_batching = source->pointer_batching;
+	}
+
 	if (source->xcursor_theme.name != NULL) {
 		free(dest->xcursor_theme.name);
 		dest->xcursor_theme.name = strdup(source->xcursor_theme.name);
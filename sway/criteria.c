@@ -2,8 +2,10 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <strings.h>
+#include <string.h>
 #define PCRE2_CODE_UNIT_WIDTH 8
 #include <pcre2.h>
+#include "sway/commands.h"
 #include "sway/criteria.h"
 #include "sway/tree/container.h"
 #include "sway/config.h"
@@ -65,6 +67,27 @@ static bool generate_regex(pcre2_code **regex, char *value) {
 	return true;
 }
 
+/**
+ * Detect regexes which are a plain string, optionally anchored at either end,
+ * such as ^firefox$. Those are matched with string comparisons instead.
+ */
+static void pattern_detect_literal(struct pattern *pattern, const char *value) {
+	size_t len = strlen(value);
+	bool anchored_start = len > 0 && value[0] == '^';
+	bool anchored_end = len > (size_t)anchored_start && value[len - 1] == '$';
+	const char *start = value + anchored_start;
+	size_t literal_len = len - anchored_start - anchored_end;
+	for (size_t i = 0; i < literal_len; ++i) {
+		if (strchr("\\^$.|?*+()[]{}", start[i])) {
+			return;
+		}
+	}
+	pattern->literal = strndup(start, literal_len);
+	pattern->literal_len = literal_len;
+	pattern->anchored_start = anchored_start;
+	pattern->anchored_end = anchored_end;
+}
+
 static bool pattern_create(struct pattern **pattern, char *value) {
 	*pattern = calloc(1, sizeof(struct pattern));
 	if (!*pattern) {
@@ -78,6 +101,9 @@ static bool pattern_create(struct pattern **pattern, char *value) {
 		if (!generate_regex(&(*pattern)->regex, value)) {
 			return false;
 		};
+		(*pattern)->match_data =
+			pcre2_match_data_create_from_pattern((*pattern)->regex, NULL);
+		pattern_detect_literal(*pattern, value);
 	}
 	return true;
 }
@@ -87,6 +113,10 @@ static void pattern_destroy(struct pattern *pattern) {
 		if (pattern->regex) {
 			pcre2_code_free(pattern->regex);
 		}
+		if (pattern->match_data) {
+			pcre2_match_data_free(pattern->match_data);
+		}
+		free(pattern->literal);
 		free(pattern);
 	}
 }
@@ -108,15 +138,45 @@ void criteria_destroy(struct criteria *criteria) {
 	pattern_destroy(criteria->tag);
 	free(criteria->target);
 	free(criteria->cmdlist);
+	compiled_command_list_destroy(criteria->compiled_cmdlist);
 	free(criteria->raw);
 	free(criteria);
 }
 
-static int regex_cmp(const char *item, const pcre2_code *regex) {
-	pcre2_match_data *match_data = pcre2_match_data_create_from_pattern(regex, NULL);
-	int result = pcre2_match(regex, (PCRE2_SPTR)item, strlen(item), 0, 0, match_data, NULL);
-	pcre2_match_data_free(match_data);
-	return result;
+// Like pcre2, $ also matches before a newline at the end of the subject
+static bool literal_ends_at(const char *item, size_t item_len,
+		const struct pattern *pattern, bool anchored_start) {
+	size_t len = pattern->literal_len;
+	for (int newline = 0; newline <= 1; ++newline) {
+		if (newline && (item_len == 0 || item[item_len - 1] != '\n')) {
+			break;
+		}
+		size_t end = item_len - newline;
+		if (end < len || (anchored_start && end != len)) {
+			continue;
+		}
+		if (memcmp(item + end - len, pattern->literal, len) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool pattern_match(const struct pattern *pattern, const char *item) {
+	if (pattern->literal) {
+		if (pattern->anchored_end) {
+			return literal_ends_at(item, strlen(item), pattern,
+				pattern->anchored_start);
+		} else if (pattern->anchored_start) {
+			return strncmp(item, pattern->literal, pattern->literal_len) == 0;
+		}
+		return strstr(item, pattern->literal) != NULL;
+	}
+	if (!pattern->match_data) {
+		return false;
+	}
+	return pcre2_match(pattern->regex, (PCRE2_SPTR)item, strlen(item), 0, 0,
+		pattern->match_data, NULL) >= 0;
 }
 
 #if WLR_HAS_XWAYLAND
@@ -171,7 +231,7 @@ static bool criteria_matches_container(struct criteria *criteria,
 		bool exists = false;
 		struct sway_container *con = container;
 		for (int i = 0; i < con->marks->length; ++i) {
-			if (regex_cmp(con->marks->items[i], criteria->con_mark->regex) >= 0) {
+			if (pattern_match(criteria->con_mark, con->marks->items[i])) {
 				exists = true;
 				break;
 			}
@@ -213,7 +273,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(title, criteria->title->regex) < 0) {
+			if (!pattern_match(criteria->title, title)) {
 				return false;
 			}
 			break;
@@ -233,7 +293,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(shell, criteria->shell->regex) < 0) {
+			if (!pattern_match(criteria->shell, shell)) {
 				return false;
 			}
 			break;
@@ -253,7 +313,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(app_id, criteria->app_id->regex) < 0) {
+			if (!pattern_match(criteria->app_id, app_id)) {
 				return false;
 			}
 			break;
@@ -273,7 +333,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(sandbox_engine, criteria->sandbox_engine->regex) < 0) {
+			if (!pattern_match(criteria->sandbox_engine, sandbox_engine)) {
 				return false;
 			}
 			break;
@@ -293,7 +353,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(sandbox_app_id, criteria->sandbox_app_id->regex) < 0) {
+			if (!pattern_match(criteria->sandbox_app_id, sandbox_app_id)) {
 				return false;
 			}
 			break;
@@ -313,7 +373,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(sandbox_instance_id, criteria->sandbox_instance_id->regex) < 0) {
+			if (!pattern_match(criteria->sandbox_instance_id, sandbox_instance_id)) {
 				return false;
 			}
 			break;
@@ -333,7 +393,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(tag, criteria->tag->regex) < 0) {
+			if (!pattern_match(criteria->tag, tag)) {
 				return false;
 			}
 			break;
@@ -365,7 +425,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(class, criteria->class->regex) < 0) {
+			if (!pattern_match(criteria->class, class)) {
 				return false;
 			}
 			break;
@@ -385,7 +445,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(instance, criteria->instance->regex) < 0) {
+			if (!pattern_match(criteria->instance, instance)) {
 				return false;
 			}
 			break;
@@ -405,7 +465,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(window_role, criteria->window_role->regex) < 0) {
+			if (!pattern_match(criteria->window_role, window_role)) {
 				return false;
 			}
 			break;
@@ -464,7 +524,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(ws->name, criteria->workspace->regex) < 0) {
+			if (!pattern_match(criteria->workspace, ws->name)) {
 				return false;
 			}
 			break;
@@ -480,15 +540,310 @@ static bool criteria_matches_view(struct criteria *criteria,
 	return true;
 }
 
+static struct view_criteria_result *view_criteria_result(
+		struct sway_view *view, struct criteria *criteria) {
+	if (criteria->position < 0) {
+		return NULL;
+	}
+	if (view->criteria_results_generation != config->criteria_generation) {
+		// The results belong to the criteria of a previous config
+		view->criteria_results_len = 0;
+		view->criteria_results_generation = config->criteria_generation;
+	}
+	if (criteria->position >= view->criteria_results_len) {
+		int len = config->criteria->length;
+		struct view_criteria_result *results =
+			realloc(view->criteria_results, len * sizeof(*results));
+		if (!results) {
+			sway_log(SWAY_ERROR, "Unable to allocate criteria results");
+			return NULL;
+		}
+		memset(results + view->criteria_results_len, 0,
+			(len - view->criteria_results_len) * sizeof(*results));
+		view->criteria_results = results;
+		view->criteria_results_len = len;
+	}
+	return &view->criteria_results[criteria->position];
+}
+
+/**
+ * Like criteria_matches_view, but reuses the previous result for the view if
+ * none of the properties the criteria depends on have changed since.
+ */
+static bool criteria_matches_view_cached(struct criteria *criteria,
+		struct sway_view *view) {
+	if (criteria->is_volatile || !view->container) {
+		return criteria_matches_view(criteria, view);
+	}
+	struct view_criteria_result *result = view_criteria_result(view, criteria);
+	if (!result) {
+		return criteria_matches_view(criteria, view);
+	}
+
+	uint32_t stamp = 0;
+	for (int i = 0; i < CRITERIA_DEP_COUNT; ++i) {
+		if (criteria->dependencies & (1 << i)) {
+			stamp += view->criteria_serials[i];
+		}
+	}
+	if (!result->valid || result->stamp != stamp) {
+		result->matched = criteria_matches_view(criteria, view);
+		result->stamp = stamp;
+		result->valid = true;
+	}
+	return result->matched;
+}
+
+bool criteria_set_executed(struct criteria *criteria, struct sway_view *view) {
+	struct view_criteria_result *result = view_criteria_result(view, criteria);
+	if (!result) {
+		return true;
+	}
+	if (result->executed) {
+		return false;
+	}
+	result->executed = true;
+	return true;
+}
+
+enum criteria_index_field {
+	CI_NONE,
+	CI_APP_ID,
+#if WLR_HAS_XWAYLAND
+	CI_CLASS,
+	CI_INSTANCE,
+#endif
+};
+
+/**
+ * Positions in the criteria list of all criteria requiring the same exact
+ * value for a field.
+ */
+struct criteria_index_bucket {
+	enum criteria_index_field field; // CI_NONE for unused slots
+	const char *key; // owned by the criteria's pattern
+
+	int *positions;
+	int length, capacity;
+};
+
+/**
+ * Open addressing hash table of criteria keyed by an exact app_id, class or
+ * instance. Criteria without such a field are kept in the unindexed bucket
+ * and are tested against every view.
+ */
+struct criteria_index {
+	struct criteria_index_bucket *buckets;
+	size_t capacity; // power of two
+	struct criteria_index_bucket unindexed;
+};
+
+static uint32_t criteria_index_hash(enum criteria_index_field field,
+		const char *key, size_t len) {
+	uint32_t hash = 2166136261u ^ field;
+	for (size_t i = 0; i < len; ++i) {
+		hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static struct criteria_index_bucket *criteria_index_find(
+		struct criteria_index *index, enum criteria_index_field field,
+		const char *key, size_t len, bool create) {
+	size_t mask = index->capacity - 1;
+	size_t i = criteria_index_hash(field, key, len) & mask;
+	for (;; i = (i + 1) & mask) {
+		struct criteria_index_bucket *bucket = &index->buckets[i];
+		if (bucket->field == CI_NONE) {
+			if (!create) {
+				return NULL;
+			}
+			bucket->field = field;
+			bucket->key = key;
+			return bucket;
+		}
+		if (bucket->field == field && strlen(bucket->key) == len &&
+				memcmp(bucket->key, key, len) == 0) {
+			return bucket;
+		}
+	}
+}
+
+static bool criteria_index_bucket_add(struct criteria_index_bucket *bucket,
+		int position) {
+	if (bucket->length == bucket->capacity) {
+		int capacity = bucket->capacity ? bucket->capacity * 2 : 4;
+		int *positions = realloc(bucket->positions,
+			capacity * sizeof(*positions));
+		if (!positions) {
+			return false;
+		}
+		bucket->positions = positions;
+		bucket->capacity = capacity;
+	}
+	bucket->positions[bucket->length++] = position;
+	return true;
+}
+
+void criteria_index_destroy(struct criteria_index *index) {
+	if (!index) {
+		return;
+	}
+	for (size_t i = 0; i < index->capacity; ++i) {
+		free(index->buckets[i].positions);
+	}
+	free(index->buckets);
+	free(index->unindexed.positions);
+	free(index);
+}
+
+static bool pattern_is_exact(struct pattern *pattern) {
+	return pattern && pattern->match_type == PATTERN_PCRE2 &&
+		pattern->literal && pattern->anchored_start && pattern->anchored_end;
+}
+
+static enum criteria_index_field criteria_index_key(struct criteria *criteria,
+		const char **key) {
+	if (pattern_is_exact(criteria->app_id)) {
+		*key = criteria->app_id->literal;
+		return CI_APP_ID;
+	}
+#if WLR_HAS_XWAYLAND
+	if (pattern_is_exact(criteria->class)) {
+		*key = criteria->class->literal;
+		return CI_CLASS;
+	}
+	if (pattern_is_exact(criteria->instance)) {
+		*key = criteria->instance->literal;
+		return CI_INSTANCE;
+	}
+#endif
+	return CI_NONE;
+}
+
+static struct criteria_index *criteria_index_create(list_t *criterias) {
+	struct criteria_index *index = calloc(1, sizeof(*index));
+	if (!index) {
+		return NULL;
+	}
+
+	// Keep the load factor at or below one half
+	index->capacity = 8;
+	while (index->capacity < (size_t)criterias->length * 2) {
+		index->capacity *= 2;
+	}
+	index->buckets = calloc(index->capacity, sizeof(*index->buckets));
+	if (!index->buckets) {
+		free(index);
+		return NULL;
+	}
+
+	for (int i = 0; i < criterias->length; ++i) {
+		const char *key = NULL;
+		enum criteria_index_field field =
+			criteria_index_key(criterias->items[i], &key);
+		struct criteria_index_bucket *bucket = field == CI_NONE ?
+			&index->unindexed :
+			criteria_index_find(index, field, key, strlen(key), true);
+		if (!criteria_index_bucket_add(bucket, i)) {
+			sway_log(SWAY_ERROR, "Unable to allocate criteria index");
+			criteria_index_destroy(index);
+			return NULL;
+		}
+	}
+	return index;
+}
+
+void criteria_add(struct criteria *criteria) {
+	criteria->position = config->criteria->length;
+	list_add(config->criteria, criteria);
+	criteria_index_destroy(config->criteria_index);
+	config->criteria_index = NULL;
+}
+
+/**
+ * Add the positions of the criteria requiring the given field value. The
+ * value may also match a key followed by a newline, as $ allows it.
+ */
+static void criteria_index_collect(struct criteria_index *index,
+		enum criteria_index_field field, const char *value, list_t *buckets) {
+	if (!value) {
+		value = "";
+	}
+	size_t len = strlen(value);
+	struct criteria_index_bucket *bucket =
+		criteria_index_find(index, field, value, len, false);
+	if (bucket) {
+		list_add(buckets, bucket);
+	}
+	if (len > 0 && value[len - 1] == '\n') {
+		bucket = criteria_index_find(index, field, value, len - 1, false);
+		if (bucket) {
+			list_add(buckets, bucket);
+		}
+	}
+}
+
+static int cmp_position(const void *a, const void *b) {
+	return *(const int *)a - *(const int *)b;
+}
+
 list_t *criteria_for_view(struct sway_view *view, enum criteria_type types) {
 	list_t *criterias = config->criteria;
 	list_t *matches = create_list();
-	for (int i = 0; i < criterias->length; ++i) {
-		struct criteria *criteria = criterias->items[i];
-		if ((criteria->type & types) && criteria_matches_view(criteria, view)) {
-			list_add(matches, criteria);
+	if (!config->criteria_index) {
+		config->criteria_index = criteria_index_create(criterias);
+	}
+	struct criteria_index *index = config->criteria_index;
+	if (!index) {
+		// Fall back to testing every criteria
+		for (int i = 0; i < criterias->length; ++i) {
+			struct criteria *criteria = criterias->items[i];
+			if ((criteria->type & types) &&
+					criteria_matches_view_cached(criteria, view)) {
+				list_add(matches, criteria);
+			}
+		}
+		return matches;
+	}
+
+	list_t *buckets = create_list();
+	list_add(buckets, &index->unindexed);
+	criteria_index_collect(index, CI_APP_ID, view_get_app_id(view), buckets);
+#if WLR_HAS_XWAYLAND
+	criteria_index_collect(index, CI_CLASS, view_get_class(view), buckets);
+	criteria_index_collect(index, CI_INSTANCE, view_get_instance(view), buckets);
+#endif
+
+	// Test the candidates in config order, so commands run in the same order
+	// as without the index
+	int ncandidates = 0;
+	for (int i = 0; i < buckets->length; ++i) {
+		struct criteria_index_bucket *bucket = buckets->items[i];
+		ncandidates += bucket->length;
+	}
+	int *candidates = malloc(ncandidates * sizeof(*candidates));
+	if (ncandidates > 0 && candidates) {
+		int n = 0;
+		for (int i = 0; i < buckets->length; ++i) {
+			struct criteria_index_bucket *bucket = buckets->items[i];
+			memcpy(candidates + n, bucket->positions,
+				bucket->length * sizeof(*candidates));
+			n += bucket->length;
+		}
+		qsort(candidates, n, sizeof(*candidates), cmp_position);
+		for (int i = 0; i < n; ++i) {
+			struct criteria *criteria = criterias->items[candidates[i]];
+			if ((criteria->type & types) &&
+					criteria_matches_view_cached(criteria, view)) {
+				list_add(matches, criteria);
+			}
 		}
+	} else if (ncandidates > 0) {
+		sway_log(SWAY_ERROR, "Unable to allocate criteria candidates");
 	}
+	free(candidates);
+	list_free(buckets);
 	return matches;
 }
 
@@ -517,7 +872,21 @@ list_t *criteria_get_containers(struct criteria *criteria) {
 		.criteria = criteria,
 		.matches = matches,
 	};
-	root_for_each_container(criteria_get_containers_iterator, &data);
+
+	// A con_id or an exact con_mark matches at most one container
+	struct sway_container *con = NULL;
+	if (criteria->con_id) {
+		con = root_find_container_by_id(criteria->con_id);
+	} else if (pattern_is_exact(criteria->con_mark)) {
+		con = root_find_container_by_mark(criteria->con_mark->literal);
+	} else {
+		root_for_each_container(criteria_get_containers_iterator, &data);
+		return matches;
+	}
+
+	if (con) {
+		criteria_get_containers_iterator(con, &data);
+	}
 	return matches;
 }
 
@@ -743,6 +1112,47 @@ static bool parse_token(struct criteria *criteria, char *name, char *value) {
 	return true;
 }
 
+static bool pattern_is_focused(struct pattern *pattern) {
+	return pattern && pattern->match_type == PATTERN_FOCUSED;
+}
+
+static void criteria_find_dependencies(struct criteria *criteria) {
+	uint32_t deps = 0;
+	if (criteria->title) {
+		deps |= 1 << CRITERIA_DEP_TITLE;
+	}
+	if (criteria->app_id) {
+		deps |= 1 << CRITERIA_DEP_APP_ID;
+	}
+	if (criteria->tag) {
+		deps |= 1 << CRITERIA_DEP_TAG;
+	}
+	if (criteria->con_mark) {
+		deps |= 1 << CRITERIA_DEP_MARKS;
+	}
+	bool is_volatile = criteria->floating || criteria->tiling ||
+		criteria->urgent || criteria->workspace ||
+		pattern_is_focused(criteria->title) ||
+		pattern_is_focused(criteria->shell) ||
+		pattern_is_focused(criteria->app_id) ||
+		pattern_is_focused(criteria->con_mark) ||
+		pattern_is_focused(criteria->sandbox_engine) ||
+		pattern_is_focused(criteria->sandbox_app_id) ||
+		pattern_is_focused(criteria->sandbox_instance_id) ||
+		pattern_is_focused(criteria->tag);
+#if WLR_HAS_XWAYLAND
+	if (criteria->class || criteria->instance || criteria->window_role ||
+			criteria->window_type != ATOM_LAST) {
+		deps |= 1 << CRITERIA_DEP_X11;
+	}
+	is_volatile = is_volatile || pattern_is_focused(criteria->class) ||
+		pattern_is_focused(criteria->instance) ||
+		pattern_is_focused(criteria->window_role);
+#endif
+	criteria->dependencies = deps;
+	criteria->is_volatile = is_volatile;
+}
+
 static void skip_spaces(char **head) {
 	while (**head == ' ') {
 		++*head;
@@ -790,6 +1200,7 @@ struct criteria *criteria_parse(char *raw, char **error_arg) {
 	++head;
 
 	struct criteria *criteria = calloc(1, sizeof(struct criteria));
+	criteria->position = -1;
 #if WLR_HAS_XWAYLAND
 	criteria->window_type = ATOM_LAST; // default value
 #endif
@@ -860,6 +1271,8 @@ struct criteria *criteria_parse(char *raw, char **error_arg) {
 		goto cleanup;
 	}
 
+	criteria_find_dependencies(criteria);
+
 	++head;
 	int len = head - raw;
 	criteria->raw = calloc(len + 1, 1);
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 #include <strings.h>
 #include <time.h>
@@ -16,6 +17,7 @@
 #include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_presentation_time.h>
 #include <wlr/types/wlr_compositor.h>
+#include <wlr/util/box.h>
 #include <wlr/util/region.h>
 #include <wlr/util/transform.h>
 #include "config.h"
@@ -29,6 +31,7 @@
 #include "sway/output.h"
 #include "sway/scene_descriptor.h"
 #include "sway/server.h"
+#include "sway/sway_text_node.h"
 #include "sway/tree/arrange.h"
 #include "sway/tree/container.h"
 #include "sway/tree/root.h"
@@ -209,16 +212,27 @@ static enum wlr_scale_filter_mode get_scale_filter(struct sway_output *output,
 	}
 }
 
+static bool container_intersects_output(struct sway_container *con,
+		struct sway_output *output) {
+	struct wlr_box con_box = {
+		.x = floor(con->current.x),
+		.y = floor(con->current.y),
+		.width = ceil(con->current.width),
+		.height = ceil(con->current.height),
+	};
+	struct wlr_box output_box, intersection;
+	output_get_box(output, &output_box);
+	return wlr_box_intersection(&intersection, &con_box, &output_box);
+}
+
 void output_configure_scene(struct sway_output *output,
 		struct wlr_scene_node *node, float opacity) {
 	if (!node->enabled) {
 		return;
 	}
 
-	struct sway_container *con =
-		scene_descriptor_try_get(node, SWAY_SCENE_DESC_CONTAINER);
-	if (con) {
-		opacity = con->alpha;
+	if (output) {
+		output->configure_stats.nodes_visited++;
 	}
 
 	if (node->type == WLR_SCENE_NODE_BUFFER) {
@@ -242,6 +256,20 @@ void output_configure_scene(struct sway_output *output,
 
 		wlr_scene_buffer_set_opacity(buffer, opacity);
 	} else if (node->type == WLR_SCENE_NODE_TREE) {
+		// Container descriptors are only ever attached to scene trees
+		struct sway_container *con =
+			scene_descriptor_try_get(node, SWAY_SCENE_DESC_CONTAINER);
+		if (con) {
+			// Containers which aren't on this output are configured by the
+			// outputs they are on. View content is clipped to the container,
+			// except for CSD which is free to draw shadows around it.
+			if (output && !container_intersects_output(con, output)) {
+				output->configure_stats.subtrees_skipped++;
+				return;
+			}
+			opacity = con->alpha;
+		}
+
 		struct wlr_scene_tree *tree = wlr_scene_tree_from_node(node);
 		struct wlr_scene_node *node;
 		wl_list_for_each(node, &tree->children, link) {
@@ -250,6 +278,67 @@ void output_configure_scene(struct sway_output *output,
 	}
 }
 
+/**
+ * Returns the tree the output places into the given root layer, or NULL if
+ * the root layer is shared between all outputs.
+ */
+static struct wlr_scene_tree *output_get_layer(struct sway_output *output,
+		struct wlr_scene_tree *root_layer) {
+	if (root_layer == root->layers.shell_background) {
+		return output->layers.shell_background;
+	} else if (root_layer == root->layers.shell_bottom) {
+		return output->layers.shell_bottom;
+	} else if (root_layer == root->layers.tiling) {
+		return output->layers.tiling;
+	} else if (root_layer == root->layers.shell_top) {
+		return output->layers.shell_top;
+	} else if (root_layer == root->layers.fullscreen) {
+		return output->layers.fullscreen;
+	} else if (root_layer == root->layers.shell_overlay) {
+		return output->layers.shell_overlay;
+	} else if (root_layer == root->layers.session_lock) {
+		return output->layers.session_lock;
+	}
+	return NULL;
+}
+
+static bool is_other_output_layer(struct sway_output *output,
+		struct wlr_scene_tree *root_layer, struct wlr_scene_node *node) {
+	for (int i = 0; i < root->outputs->length; i++) {
+		struct sway_output *other = root->outputs->items[i];
+		if (other != output && node == &output_get_layer(other, root_layer)->node) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Configures the part of the scene that can be displayed on the output.
+ * Instead of walking the whole scene, the trees that other outputs place into
+ * the root layers are skipped.
+ */
+static void output_configure_scene_layers(struct sway_output *output) {
+	struct wlr_scene_node *layer_node;
+	wl_list_for_each(layer_node, &root->layer_tree->children, link) {
+		if (!layer_node->enabled) {
+			continue;
+		}
+
+		struct wlr_scene_tree *layer = wlr_scene_tree_from_node(layer_node);
+		bool per_output = output_get_layer(output, layer) != NULL;
+
+		struct wlr_scene_node *node;
+		wl_list_for_each(node, &layer->children, link) {
+			if (per_output && is_other_output_layer(output, layer, node)) {
+				output->configure_stats.subtrees_skipped++;
+				continue;
+			}
+			output_configure_scene(output, node, 1.0f);
+		}
+	}
+}
+
 static bool output_can_tear(struct sway_output *output) {
 	struct sway_workspace *workspace = output->current.active_workspace;
 	if (!workspace) {
@@ -275,7 +364,8 @@ static int output_repaint_timer_handler(void *data) {
 		return 0;
 	}
 
-	output_configure_scene(output, &root->root_scene->tree.node, 1.0f);
+	sway_text_node_flush();
+	output_configure_scene_layers(output);
 
 	struct wlr_scene_output_state_options opts = {
 		.color_transform = output->color_transform,
@@ -9,6 +9,7 @@
 #include "sway/desktop/transaction.h"
 #include "sway/input/cursor.h"
 #include "sway/input/input-manager.h"
+#include "sway/ipc-server.h"
 #include "sway/output.h"
 #include "sway/server.h"
 #include "sway/tree/container.h"
@@ -39,26 +40,107 @@ struct sway_transaction_instruction {
 	bool waiting;
 };
 
+// Upper bound on the number of instructions and lists kept for reuse
+#define TRANSACTION_POOL_MAX 4096
+
+static list_t *pool_get_list(void) {
+	list_t *pool = server.txn_list_pool;
+	if (pool->length > 0) {
+		server.txn_pool_stats.lists_reused++;
+		return pool->items[--pool->length];
+	}
+	server.txn_pool_stats.lists_allocated++;
+	return create_list();
+}
+
+static void pool_put_list(list_t *list) {
+	if (!list) {
+		return;
+	}
+	if (server.txn_list_pool->length >= TRANSACTION_POOL_MAX) {
+		list_free(list);
+		return;
+	}
+	list->length = 0;
+	list_add(server.txn_list_pool, list);
+}
+
+static struct sway_transaction_instruction *instruction_create(void) {
+	list_t *pool = server.txn_instruction_pool;
+	if (pool->length > 0) {
+		server.txn_pool_stats.instructions_reused++;
+		return pool->items[--pool->length];
+	}
+	server.txn_pool_stats.instructions_allocated++;
+	return calloc(1, sizeof(struct sway_transaction_instruction));
+}
+
+/**
+ * Return an instruction and the state lists it holds to the pools. The lists
+ * are either the ones copied from the pending state, or if the transaction was
+ * applied, the node's previous current state lists.
+ */
+static void instruction_release(struct sway_transaction_instruction *instruction,
+		enum sway_node_type type) {
+	switch (type) {
+	case N_ROOT:
+		break;
+	case N_OUTPUT:
+		pool_put_list(instruction->output_state.workspaces);
+		break;
+	case N_WORKSPACE:
+		pool_put_list(instruction->workspace_state.floating);
+		pool_put_list(instruction->workspace_state.tiling);
+		break;
+	case N_CONTAINER:
+		pool_put_list(instruction->container_state.children);
+		break;
+	}
+
+	if (server.txn_instruction_pool->length >= TRANSACTION_POOL_MAX) {
+		free(instruction);
+		return;
+	}
+	memset(instruction, 0, sizeof(*instruction));
+	list_add(server.txn_instruction_pool, instruction);
+}
+
+void transaction_pool_finish(void) {
+	list_free_items_and_destroy(server.txn_instruction_pool);
+	server.txn_instruction_pool = NULL;
+	if (server.txn_list_pool) {
+		for (int i = 0; i < server.txn_list_pool->length; ++i) {
+			list_free(server.txn_list_pool->items[i]);
+		}
+		list_free(server.txn_list_pool);
+		server.txn_list_pool = NULL;
+	}
+}
+
 static struct sway_transaction *transaction_create(void) {
 	struct sway_transaction *transaction =
 		calloc(1, sizeof(struct sway_transaction));
 	if (!sway_assert(transaction, "Unable to allocate transaction")) {
 		return NULL;
 	}
-	transaction->instructions = create_list();
+	transaction->instructions = pool_get_list();
 	return transaction;
 }
 
 static void transaction_destroy(struct sway_transaction *transaction) {
-	// Free instructions
+	// Release instructions
 	for (int i = 0; i < transaction->instructions->length; ++i) {
 		struct sway_transaction_instruction *instruction =
 			transaction->instructions->items[i];
 		struct sway_node *node = instruction->node;
+		enum sway_node_type type = node->type;
 		node->ntxnrefs--;
 		if (node->instruction == instruction) {
 			node->instruction = NULL;
 		}
+		if (node->pending_instruction == instruction) {
+			node->pending_instruction = NULL;
+		}
 		if (node->destroying && node->ntxnrefs == 0 && !node->dirty) {
 			switch (node->type) {
 			case N_ROOT:
@@ -75,9 +157,9 @@ static void transaction_destroy(struct sway_transaction *transaction) {
 				break;
 			}
 		}
-		free(instruction);
+		instruction_release(instruction, type);
 	}
-	list_free(transaction->instructions);
+	pool_put_list(transaction->instructions);
 
 	if (transaction->timer) {
 		wl_event_source_remove(transaction->timer);
@@ -91,7 +173,7 @@ static void copy_output_state(struct sway_output *output,
 	if (state->workspaces) {
 		state->workspaces->length = 0;
 	} else {
-		state->workspaces = create_list();
+		state->workspaces = pool_get_list();
 	}
 	list_cat(state->workspaces, output->workspaces);
 
@@ -113,12 +195,12 @@ static void copy_workspace_state(struct sway_workspace *ws,
 	if (state->floating) {
 		state->floating->length = 0;
 	} else {
-		state->floating = create_list();
+		state->floating = pool_get_list();
 	}
 	if (state->tiling) {
 		state->tiling->length = 0;
 	} else {
-		state->tiling = create_list();
+		state->tiling = pool_get_list();
 	}
 	list_cat(state->floating, ws->floating);
 	list_cat(state->tiling, ws->tiling);
@@ -140,18 +222,22 @@ static void copy_container_state(struct sway_container *container,
 		struct sway_transaction_instruction *instruction) {
 	struct sway_container_state *state = &instruction->container_state;
 
-	if (state->children) {
-		list_free(state->children);
-	}
+	list_t *children = state->children;
 
 	memcpy(state, &container->pending, sizeof(struct sway_container_state));
 
 	if (!container->view) {
 		// We store a copy of the child list to avoid having it mutated after
 		// we copy the state.
-		state->children = create_list();
+		if (children) {
+			children->length = 0;
+		} else {
+			children = pool_get_list();
+		}
+		state->children = children;
 		list_cat(state->children, container->pending.children);
 	} else {
+		pool_put_list(children);
 		state->children = NULL;
 	}
 
@@ -165,25 +251,75 @@ static void copy_container_state(struct sway_container *container,
 	}
 }
 
+static bool container_state_changed(struct sway_container *container) {
+	struct sway_container_state *pending = &container->pending;
+	struct sway_container_state *current = &container->current;
+
+	if (pending->layout != current->layout ||
+			pending->x != current->x || pending->y != current->y ||
+			pending->width != current->width ||
+			pending->height != current->height ||
+			pending->fullscreen_mode != current->fullscreen_mode ||
+			pending->workspace != current->workspace ||
+			pending->parent != current->parent ||
+			pending->border != current->border ||
+			pending->border_thickness != current->border_thickness ||
+			pending->border_top != current->border_top ||
+			pending->border_bottom != current->border_bottom ||
+			pending->border_left != current->border_left ||
+			pending->border_right != current->border_right ||
+			pending->content_x != current->content_x ||
+			pending->content_y != current->content_y ||
+			pending->content_width != current->content_width ||
+			pending->content_height != current->content_height) {
+		return true;
+	}
+
+	// Focus is taken from the seat when the state is copied
+	struct sway_seat *seat = input_manager_current_seat();
+	if ((seat_get_focus(seat) == &container->node) != current->focused) {
+		return true;
+	}
+	if (container->view) {
+		return false;
+	}
+
+	if (pending->children->length != current->children->length ||
+			memcmp(pending->children->items, current->children->items,
+				pending->children->length * sizeof(void *)) != 0) {
+		return true;
+	}
+	struct sway_node *focus =
+		seat_get_active_tiling_child(seat, &container->node);
+	return (focus ? focus->sway_container : NULL) !=
+		current->focused_inactive_child;
+}
+
+bool transaction_set_dirty_if_changed(struct sway_container *con) {
+	struct sway_node *node = &con->node;
+	if (node->dirty) {
+		return true;
+	}
+	// The current state is only final when no transaction references it
+	if (node->ntxnrefs == 0 && !container_state_changed(con)) {
+		return false;
+	}
+	node_set_dirty(node);
+	return node->dirty;
+}
+
 static void transaction_add_node(struct sway_transaction *transaction,
 		struct sway_node *node, bool server_request) {
-	struct sway_transaction_instruction *instruction = NULL;
-
 	// Check if we have an instruction for this node already, in which case we
 	// update that instead of creating a new one.
-	if (node->ntxnrefs > 0) {
-		for (int idx = 0; idx < transaction->instructions->length; idx++) {
-			struct sway_transaction_instruction *other =
-				transaction->instructions->items[idx];
-			if (other->node == node) {
-				instruction = other;
-				break;
-			}
-		}
+	struct sway_transaction_instruction *instruction = node->pending_instruction;
+	if (instruction && !sway_assert(instruction->transaction == transaction,
+				"Pending instruction belongs to another transaction")) {
+		instruction = NULL;
 	}
 
 	if (!instruction) {
-		instruction = calloc(1, sizeof(struct sway_transaction_instruction));
+		instruction = instruction_create();
 		if (!sway_assert(instruction, "Unable to allocate instruction")) {
 			return;
 		}
@@ -192,6 +328,7 @@ static void transaction_add_node(struct sway_transaction *transaction,
 		instruction->server_request = server_request;
 
 		list_add(transaction->instructions, instruction);
+		node->pending_instruction = instruction;
 		node->ntxnrefs++;
 	} else if (server_request) {
 		instruction->server_request = true;
@@ -212,17 +349,23 @@ static void transaction_add_node(struct sway_transaction *transaction,
 	}
 }
 
+// The lists of the previous current state are handed back to the instruction,
+// which returns them to the pool when the transaction is destroyed.
+
 static void apply_output_state(struct sway_output *output,
 		struct sway_output_state *state) {
-	list_free(output->current.workspaces);
+	list_t *workspaces = output->current.workspaces;
 	memcpy(&output->current, state, sizeof(struct sway_output_state));
+	state->workspaces = workspaces;
 }
 
 static void apply_workspace_state(struct sway_workspace *ws,
 		struct sway_workspace_state *state) {
-	list_free(ws->current.floating);
-	list_free(ws->current.tiling);
+	list_t *floating = ws->current.floating;
+	list_t *tiling = ws->current.tiling;
 	memcpy(&ws->current, state, sizeof(struct sway_workspace_state));
+	state->floating = floating;
+	state->tiling = tiling;
 }
 
 static void apply_container_state(struct sway_container *container,
@@ -230,12 +373,14 @@ static void apply_container_state(struct sway_container *container,
 	struct sway_view *view = container->view;
 	// There are separate children lists for each instruction state, the
 	// container's current state and the container's pending state
-	// (ie. con->children). The list itself needs to be freed here.
+	// (ie. con->children). The previous list is recycled along with the
+	// instruction.
 	// Any child containers which are being deleted will be cleaned up in
 	// transaction_destroy().
-	list_free(container->current.children);
+	list_t *children = container->current.children;
 
 	memcpy(&container->current, state, sizeof(struct sway_container_state));
+	state->children = children;
 
 	if (view) {
 		if (view->saved_surface_tree) {
@@ -715,6 +860,8 @@ static void arrange_root(struct sway_root *root) {
  */
 static void transaction_apply(struct sway_transaction *transaction) {
 	sway_log(SWAY_DEBUG, "Applying transaction %p", transaction);
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
 	if (debug.txn_timings) {
 		struct timespec now;
 		clock_gettime(CLOCK_MONOTONIC, &now);
@@ -749,6 +896,8 @@ static void transaction_apply(struct sway_transaction *transaction) {
 
 		node->instruction = NULL;
 	}
+
+	histogram_add_since(&server.timings.transaction_apply, &start);
 }
 
 static void transaction_commit_pending(void);
@@ -845,6 +994,7 @@ static void transaction_commit(struct sway_transaction *transaction) {
 			view_save_buffer(node->sway_container->view);
 		}
 		node->instruction = instruction;
+		node->pending_instruction = NULL;
 	}
 	transaction->num_configures = transaction->num_waiting;
 	if (debug.txn_timings) {
@@ -943,6 +1093,9 @@ static void _transaction_commit_dirty(bool server_request) {
 		return;
 	}
 
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
 	if (!server.pending_transaction) {
 		server.pending_transaction = transaction_create();
 		if (!server.pending_transaction) {
@@ -958,6 +1111,8 @@ static void _transaction_commit_dirty(bool server_request) {
 	server.dirty_nodes->length = 0;
 
 	transaction_commit_pending();
+	ipc_event_tree_schedule();
+	histogram_add_since(&server.timings.transaction_commit, &start);
 }
 
 void transaction_commit_dirty(void) {
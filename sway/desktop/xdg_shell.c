@@ -352,8 +352,7 @@ static void handle_set_title(struct wl_listener *listener, void *data) {
 	struct sway_xdg_shell_view *xdg_shell_view =
 		wl_container_of(listener, xdg_shell_view, set_title);
 	struct sway_view *view = &xdg_shell_view->view;
-	view_update_title(view, false);
-	view_execute_criteria(view);
+	view_request_title_update(view);
 	transaction_commit_dirty();
 }
 
@@ -361,6 +360,7 @@ static void handle_set_app_id(struct wl_listener *listener, void *data) {
 	struct sway_xdg_shell_view *xdg_shell_view =
 		wl_container_of(listener, xdg_shell_view, set_app_id);
 	struct sway_view *view = &xdg_shell_view->view;
+	view->criteria_serials[CRITERIA_DEP_APP_ID]++;
 	view_update_app_id(view);
 	view_execute_criteria(view);
 	transaction_commit_dirty();
@@ -598,6 +598,7 @@ void xdg_toplevel_tag_manager_v1_handle_set_tag(struct wl_listener *listener, vo
 	struct sway_xdg_shell_view *xdg_shell_view = xdg_shell_view_from_view(view);
 	free(xdg_shell_view->tag);
 	xdg_shell_view->tag = strdup(event->tag);
+	view->criteria_serials[CRITERIA_DEP_TAG]++;
 	view_execute_criteria(view);
 	transaction_commit_dirty();
 }
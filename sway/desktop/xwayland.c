@@ -687,8 +687,7 @@ static void handle_set_title(struct wl_listener *listener, void *data) {
 	if (xsurface->surface == NULL || !xsurface->surface->mapped) {
 		return;
 	}
-	view_update_title(view, false);
-	view_execute_criteria(view);
+	view_request_title_update(view);
 	transaction_commit_dirty();
 }
 
@@ -700,6 +699,7 @@ static void handle_set_class(struct wl_listener *listener, void *data) {
 	if (xsurface->surface == NULL || !xsurface->surface->mapped) {
 		return;
 	}
+	view->criteria_serials[CRITERIA_DEP_X11]++;
 	view_execute_criteria(view);
 	transaction_commit_dirty();
 }
@@ -712,6 +712,7 @@ static void handle_set_role(struct wl_listener *listener, void *data) {
 	if (xsurface->surface == NULL || !xsurface->surface->mapped) {
 		return;
 	}
+	view->criteria_serials[CRITERIA_DEP_X11]++;
 	view_execute_criteria(view);
 	transaction_commit_dirty();
 }
@@ -749,6 +750,7 @@ static void handle_set_window_type(struct wl_listener *listener, void *data) {
 	if (xsurface->surface == NULL || !xsurface->surface->mapped) {
 		return;
 	}
+	view->criteria_serials[CRITERIA_DEP_X11]++;
 	view_execute_criteria(view);
 	transaction_commit_dirty();
 }
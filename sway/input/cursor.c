@@ -73,20 +73,22 @@ struct sway_node *node_at_coords(
 		// determine what container we clicked on
 		struct wlr_scene_node *current = scene_node;
 		while (true) {
-			struct sway_container *con = scene_descriptor_try_get(current,
-				SWAY_SCENE_DESC_CONTAINER);
+			struct sway_scene_descriptor *desc = scene_descriptor_get(current);
+			if (!desc) {
+				goto next;
+			}
+
+			struct sway_container *con = desc->data[SWAY_SCENE_DESC_CONTAINER];
 
 			if (!con) {
-				struct sway_view *view = scene_descriptor_try_get(current,
-					SWAY_SCENE_DESC_VIEW);
+				struct sway_view *view = desc->data[SWAY_SCENE_DESC_VIEW];
 				if (view) {
 					con = view->container;
 				}
 			}
 
 			if (!con) {
-				struct sway_popup_desc *popup =
-					scene_descriptor_try_get(current, SWAY_SCENE_DESC_POPUP);
+				struct sway_popup_desc *popup = desc->data[SWAY_SCENE_DESC_POPUP];
 				if (popup && popup->view) {
 					con = popup->view->container;
 				}
@@ -96,18 +98,19 @@ struct sway_node *node_at_coords(
 				return &con->node;
 			}
 
-			if (scene_descriptor_try_get(current, SWAY_SCENE_DESC_LAYER_SHELL)) {
+			if (desc->data[SWAY_SCENE_DESC_LAYER_SHELL]) {
 				// We don't want to feed through the current workspace on
 				// layer shells
 				return NULL;
 			}
 
 #if WLR_HAS_XWAYLAND
-			if (scene_descriptor_try_get(current, SWAY_SCENE_DESC_XWAYLAND_UNMANAGED)) {
+			if (desc->data[SWAY_SCENE_DESC_XWAYLAND_UNMANAGED]) {
 				return NULL;
 			}
 #endif
 
+next:
 			if (!current->parent) {
 				break;
 			}
@@ -287,6 +290,54 @@ void cursor_unhide(struct sway_cursor *cursor) {
 	wl_event_source_timer_update(cursor->hide_source, cursor_get_timeout(cursor));
 }
 
+void cursor_flush_motion(struct sway_cursor *cursor) {
+	if (!cursor->motion_batch.pending) {
+		return;
+	}
+	cursor->motion_batch.pending = false;
+	if (cursor->motion_batch.idle) {
+		wl_event_source_remove(cursor->motion_batch.idle);
+		cursor->motion_batch.idle = NULL;
+	}
+
+	seatop_pointer_motion(cursor->seat, cursor->motion_batch.time_msec);
+	if (cursor->motion_batch.frame) {
+		cursor->motion_batch.frame = false;
+		wlr_seat_pointer_notify_frame(cursor->seat->wlr_seat);
+	}
+}
+
+static void handle_motion_batch_idle(void *data) {
+	struct sway_cursor *cursor = data;
+	// Idle sources are removed after they are dispatched
+	cursor->motion_batch.idle = NULL;
+	cursor_flush_motion(cursor);
+}
+
+/**
+ * Defer the seatop motion handling until the event loop is idle, i.e. after
+ * every input event which has already arrived has been read. This doesn't
+ * add latency: the batch is handled before sway waits for more events, and
+ * before any other input event.
+ */
+static void cursor_defer_motion(struct sway_cursor *cursor,
+		uint32_t time_msec) {
+	cursor->motion_batch.time_msec = time_msec;
+	if (cursor->motion_batch.pending) {
+		cursor->motion_batch.coalesced++;
+		return;
+	}
+
+	cursor->motion_batch.idle = wl_event_loop_add_idle(server.wl_event_loop,
+		handle_motion_batch_idle, cursor);
+	if (!cursor->motion_batch.idle) {
+		seatop_pointer_motion(cursor->seat, time_msec);
+		return;
+	}
+	cursor->motion_batch.pending = true;
+	cursor->motion_batch.batches++;
+}
+
 void pointer_motion(struct sway_cursor *cursor, uint32_t time_msec,
 		struct wlr_input_device *device, double dx, double dy,
 		double dx_unaccel, double dy_unaccel) {
@@ -318,7 +369,15 @@ void pointer_motion(struct sway_cursor *cursor, uint32_t time_msec,
 
 	wlr_cursor_move(cursor->cursor, device, dx, dy);
 
-	seatop_pointer_motion(cursor->seat, time_msec);
+	// Relative motion has been sent in full above, and the cursor image
+	// moves right away. Hit-testing, focus changes and wl_pointer.motion only
+	// need the final position of a burst of events from a real pointer.
+	if (cursor->motion_batching && device->type == WLR_INPUT_DEVICE_POINTER) {
+		cursor_defer_motion(cursor, time_msec);
+	} else {
+		cursor_flush_motion(cursor);
+		seatop_pointer_motion(cursor->seat, time_msec);
+	}
 }
 
 static void handle_pointer_motion_relative(
@@ -392,6 +451,12 @@ static void handle_pointer_axis(struct wl_listener *listener, void *data) {
 
 static void handle_pointer_frame(struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor = wl_container_of(listener, cursor, frame);
+	if (cursor->motion_batch.pending) {
+		// The batched motion gets a frame of its own when it is flushed
+		cursor->motion_batch.frame = true;
+	}
+	// Relative motion is not batched, and clients such as Xwayland only keep
+	// the last relative delta of each frame
 	wlr_seat_pointer_notify_frame(cursor->seat->wlr_seat);
 }
 
@@ -1025,6 +1090,9 @@ void sway_cursor_destroy(struct sway_cursor *cursor) {
 	}
 
 	wl_event_source_remove(cursor->hide_source);
+	if (cursor->motion_batch.idle) {
+		wl_event_source_remove(cursor->motion_batch.idle);
+	}
 
 	wl_list_remove(&cursor->image_surface_destroy.link);
 	wl_list_remove(&cursor->hold_begin.link);
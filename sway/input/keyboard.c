@@ -151,108 +151,292 @@ static bool update_shortcut_state(struct sway_shortcut_state *state,
 	return false;
 }
 
+struct binding_index_item {
+	struct sway_binding *binding;
+	int position; // index in the mode's binding list
+	bool any_input;
+};
+
 /**
- * If one exists, finds a binding which matches the shortcut model state,
- * current modifiers, release state, and locked state.
+ * All bindings of a mode sharing the same modifiers, release flag, number of
+ * keys and first key. Items are kept in the order of the binding list.
  */
-static void get_active_binding(const struct sway_shortcut_state *state,
-		list_t *bindings, struct sway_binding **current_binding,
-		uint32_t modifiers, bool release, bool locked, bool inhibited,
-		const char *input, bool exact_input, xkb_layout_index_t group) {
+struct binding_index_bucket {
+	uint32_t modifiers;
+	uint32_t first_key;
+	uint32_t nkeys;
+	bool release;
+
+	struct binding_index_item *items;
+	int length, capacity;
+};
+
+/**
+ * Open addressing hash table of binding buckets, built from a mode's keysym
+ * or keycode binding list the first time it is needed.
+ */
+struct sway_binding_index {
+	struct binding_index_bucket *buckets;
+	size_t capacity; // power of two, zero if there are no bindings
+};
+
+static uint32_t binding_index_hash(uint32_t modifiers, uint32_t first_key,
+		uint32_t nkeys, bool release) {
+	uint32_t hash = first_key * 0x9e3779b1u;
+	hash ^= (modifiers << 8 | nkeys << 1 | release) * 0x85ebca77u;
+	hash ^= hash >> 15;
+	return hash;
+}
+
+static struct binding_index_bucket *binding_index_find(
+		struct sway_binding_index *index, uint32_t modifiers,
+		uint32_t first_key, uint32_t nkeys, bool release, bool create) {
+	if (index->capacity == 0) {
+		return NULL;
+	}
+	size_t mask = index->capacity - 1;
+	size_t i = binding_index_hash(modifiers, first_key, nkeys, release) & mask;
+	for (;; i = (i + 1) & mask) {
+		struct binding_index_bucket *bucket = &index->buckets[i];
+		if (!bucket->items) {
+			if (!create) {
+				return NULL;
+			}
+			bucket->modifiers = modifiers;
+			bucket->first_key = first_key;
+			bucket->nkeys = nkeys;
+			bucket->release = release;
+			return bucket;
+		}
+		if (bucket->modifiers == modifiers && bucket->first_key == first_key &&
+				bucket->nkeys == nkeys && bucket->release == release) {
+			return bucket;
+		}
+	}
+}
+
+static bool binding_index_bucket_add(struct binding_index_bucket *bucket,
+		struct sway_binding *binding, int position) {
+	if (bucket->length == bucket->capacity) {
+		int capacity = bucket->capacity ? bucket->capacity * 2 : 4;
+		struct binding_index_item *items =
+			realloc(bucket->items, capacity * sizeof(*items));
+		if (!items) {
+			return false;
+		}
+		bucket->items = items;
+		bucket->capacity = capacity;
+	}
+	bucket->items[bucket->length++] = (struct binding_index_item){
+		.binding = binding,
+		.position = position,
+		.any_input = strcmp(binding->input, "*") == 0,
+	};
+	return true;
+}
+
+static void binding_index_destroy(struct sway_binding_index *index) {
+	if (!index) {
+		return;
+	}
+	for (size_t i = 0; i < index->capacity; i++) {
+		free(index->buckets[i].items);
+	}
+	free(index->buckets);
+	free(index);
+}
+
+static struct sway_binding_index *binding_index_create(list_t *bindings) {
+	struct sway_binding_index *index = calloc(1, sizeof(*index));
+	if (!index) {
+		return NULL;
+	}
+	if (bindings->length == 0) {
+		return index;
+	}
+
+	// Keep the load factor at or below one half
+	index->capacity = 8;
+	while (index->capacity < (size_t)bindings->length * 2) {
+		index->capacity *= 2;
+	}
+	index->buckets = calloc(index->capacity, sizeof(*index->buckets));
+	if (!index->buckets) {
+		free(index);
+		return NULL;
+	}
+
 	for (int i = 0; i < bindings->length; ++i) {
 		struct sway_binding *binding = bindings->items[i];
-		bool binding_locked = (binding->flags & BINDING_LOCKED) != 0;
-		bool binding_inhibited = (binding->flags & BINDING_INHIBITED) != 0;
-		bool binding_release = binding->flags & BINDING_RELEASE;
-
-		if (modifiers ^ binding->modifiers ||
-				release != binding_release ||
-				locked > binding_locked ||
-				inhibited > binding_inhibited ||
-				(binding->group != XKB_LAYOUT_INVALID &&
-				 binding->group != group) ||
-				(strcmp(binding->input, input) != 0 &&
-				 (strcmp(binding->input, "*") != 0 || exact_input))) {
-			continue;
+		uint32_t first_key = binding->keys->length > 0 ?
+			*(uint32_t *)binding->keys->items[0] : 0;
+		struct binding_index_bucket *bucket = binding_index_find(index,
+			binding->modifiers, first_key, binding->keys->length,
+			binding->flags & BINDING_RELEASE, true);
+		if (!binding_index_bucket_add(bucket, binding, i)) {
+			sway_log(SWAY_ERROR, "Unable to allocate binding index");
+			binding_index_destroy(index);
+			return NULL;
 		}
+	}
+	return index;
+}
 
-		bool match = false;
-		if (state->npressed == (size_t)binding->keys->length) {
-			match = true;
-			for (size_t j = 0; j < state->npressed; j++) {
-				uint32_t key = *(uint32_t *)binding->keys->items[j];
-				if (key != state->pressed_keys[j]) {
-					match = false;
-					break;
-				}
+void sway_mode_reset_binding_index(struct sway_mode *mode) {
+	binding_index_destroy(mode->keysym_index);
+	binding_index_destroy(mode->keycode_index);
+	mode->keysym_index = NULL;
+	mode->keycode_index = NULL;
+}
+
+static struct sway_binding_index *mode_get_binding_index(
+		struct sway_mode *mode, enum binding_input_type type) {
+	struct sway_binding_index **index = type == BINDING_KEYCODE ?
+		&mode->keycode_index : &mode->keysym_index;
+	if (!*index) {
+		*index = binding_index_create(type == BINDING_KEYCODE ?
+			mode->keycode_bindings : mode->keysym_bindings);
+	}
+	return *index;
+}
+
+/**
+ * Checks a candidate from the binding index against the input state and
+ * updates the current binding accordingly.
+ *
+ * Returns true if the current binding is a perfect match and the search can
+ * stop.
+ */
+static bool check_candidate_binding(const struct sway_shortcut_state *state,
+		const struct binding_index_item *item,
+		struct sway_binding **current_binding,
+		bool locked, bool inhibited, const char *input, bool exact_input,
+		xkb_layout_index_t group) {
+	struct sway_binding *binding = item->binding;
+	bool binding_locked = (binding->flags & BINDING_LOCKED) != 0;
+	bool binding_inhibited = (binding->flags & BINDING_INHIBITED) != 0;
+
+	if (locked > binding_locked ||
+			inhibited > binding_inhibited ||
+			(binding->group != XKB_LAYOUT_INVALID &&
+			 binding->group != group) ||
+			((!item->any_input || exact_input) &&
+			 strcmp(binding->input, input) != 0)) {
+		return false;
+	}
+
+	if (state->npressed == (size_t)binding->keys->length) {
+		for (size_t j = 1; j < state->npressed; j++) {
+			uint32_t key = *(uint32_t *)binding->keys->items[j];
+			if (key != state->pressed_keys[j]) {
+				return false;
 			}
-		} else if (binding->keys->length == 1) {
-			/*
-			 * If no multiple-key binding has matched, try looking for
-			 * single-key bindings that match the newly-pressed key.
-			 */
-			match = state->current_key == *(uint32_t *)binding->keys->items[0];
-		}
-		if (!match) {
-			continue;
 		}
+	}
 
-		if (*current_binding) {
-			if (*current_binding == binding) {
-				continue;
-			}
+	if (*current_binding) {
+		if (*current_binding == binding) {
+			return false;
+		}
 
-			bool current_locked =
-				((*current_binding)->flags & BINDING_LOCKED) != 0;
-			bool current_inhibited =
-				((*current_binding)->flags & BINDING_INHIBITED) != 0;
-			bool current_input = strcmp((*current_binding)->input, input) == 0;
-			bool current_group_set =
-				(*current_binding)->group != XKB_LAYOUT_INVALID;
-			bool binding_input = strcmp(binding->input, input) == 0;
-			bool binding_group_set = binding->group != XKB_LAYOUT_INVALID;
-
-			if (current_input == binding_input
-					&& current_locked == binding_locked
-					&& current_inhibited == binding_inhibited
-					&& current_group_set == binding_group_set) {
-				sway_log(SWAY_DEBUG,
-						"Encountered conflicting bindings %d and %d",
-						(*current_binding)->order, binding->order);
-				continue;
-			}
+		bool current_locked =
+			((*current_binding)->flags & BINDING_LOCKED) != 0;
+		bool current_inhibited =
+			((*current_binding)->flags & BINDING_INHIBITED) != 0;
+		bool current_input = strcmp((*current_binding)->input, input) == 0;
+		bool current_group_set =
+			(*current_binding)->group != XKB_LAYOUT_INVALID;
+		bool binding_input = strcmp(binding->input, input) == 0;
+		bool binding_group_set = binding->group != XKB_LAYOUT_INVALID;
+
+		if (current_input == binding_input
+				&& current_locked == binding_locked
+				&& current_inhibited == binding_inhibited
+				&& current_group_set == binding_group_set) {
+			sway_log(SWAY_DEBUG,
+					"Encountered conflicting bindings %d and %d",
+					(*current_binding)->order, binding->order);
+			return false;
+		}
 
-			if (current_input && !binding_input) {
-				continue; // Prefer the correct input
-			}
+		if (current_input && !binding_input) {
+			return false; // Prefer the correct input
+		}
 
-			if (current_input == binding_input &&
-				   (*current_binding)->group == group) {
-				continue; // Prefer correct group for matching inputs
-			}
+		if (current_input == binding_input &&
+			   (*current_binding)->group == group) {
+			return false; // Prefer correct group for matching inputs
+		}
 
-			if (current_input == binding_input &&
-					current_group_set == binding_group_set &&
-					current_locked == locked) {
-				continue; // Prefer correct lock state for matching input+group
-			}
+		if (current_input == binding_input &&
+				current_group_set == binding_group_set &&
+				current_locked == locked) {
+			return false; // Prefer correct lock state for matching input+group
+		}
 
-			if (current_input == binding_input &&
-					current_group_set == binding_group_set &&
-					current_locked == binding_locked &&
-					current_inhibited == inhibited) {
-				// Prefer correct inhibition state for matching
-				// input+group+locked
-				continue;
-			}
+		if (current_input == binding_input &&
+				current_group_set == binding_group_set &&
+				current_locked == binding_locked &&
+				current_inhibited == inhibited) {
+			// Prefer correct inhibition state for matching
+			// input+group+locked
+			return false;
 		}
+	}
+
+	*current_binding = binding;
+	// If a perfect match is found, quit searching
+	return strcmp((*current_binding)->input, input) == 0 &&
+		(((*current_binding)->flags & BINDING_LOCKED) == locked) &&
+		(((*current_binding)->flags & BINDING_INHIBITED) == inhibited) &&
+		(*current_binding)->group == group;
+}
+
+/**
+ * If one exists, finds a binding which matches the shortcut model state,
+ * current modifiers, release state, and locked state.
+ *
+ * Only the buckets of the binding index which can match are visited: the
+ * bindings with all of the pressed keys and, failing that, the single-key
+ * bindings for the newly-pressed key. Both are visited in binding list order
+ * so that conflicts resolve the same way as a linear scan would.
+ */
+static void get_active_binding(const struct sway_shortcut_state *state,
+		struct sway_binding_index *index, struct sway_binding **current_binding,
+		uint32_t modifiers, bool release, bool locked, bool inhibited,
+		const char *input, bool exact_input, xkb_layout_index_t group) {
+	if (!index) {
+		return;
+	}
 
-		*current_binding = binding;
-		if (strcmp((*current_binding)->input, input) == 0 &&
-				(((*current_binding)->flags & BINDING_LOCKED) == locked) &&
-				(((*current_binding)->flags & BINDING_INHIBITED) == inhibited) &&
-				(*current_binding)->group == group) {
-			return; // If a perfect match is found, quit searching
+	uint32_t first_key = state->npressed > 0 ? state->pressed_keys[0] : 0;
+	struct binding_index_bucket *all_keys = binding_index_find(index,
+		modifiers, first_key, state->npressed, release, false);
+
+	/*
+	 * If no multiple-key binding has matched, try looking for
+	 * single-key bindings that match the newly-pressed key.
+	 */
+	struct binding_index_bucket *new_key = NULL;
+	if (state->npressed != 1) {
+		new_key = binding_index_find(index,
+			modifiers, state->current_key, 1, release, false);
+	}
+
+	int i = 0, j = 0;
+	int all_keys_len = all_keys ? all_keys->length : 0;
+	int new_key_len = new_key ? new_key->length : 0;
+	while (i < all_keys_len || j < new_key_len) {
+		const struct binding_index_item *item;
+		if (j >= new_key_len || (i < all_keys_len &&
+				all_keys->items[i].position < new_key->items[j].position)) {
+			item = &all_keys->items[i++];
+		} else {
+			item = &new_key->items[j++];
+		}
+		if (check_candidate_binding(state, item, current_binding,
+				locked, inhibited, input, exact_input, group)) {
+			return;
 		}
 	}
 }
@@ -439,6 +623,8 @@ static void handle_key_event(struct sway_keyboard *keyboard,
 	char *device_identifier = input_device_get_identifier(wlr_device);
 	bool exact_identifier = keyboard->wlr->group != NULL;
 	seat_idle_notify_activity(seat, IDLE_SOURCE_KEYBOARD);
+	// Keys may depend on the focus set by focus_follows_mouse
+	cursor_flush_motion(seat->cursor);
 	bool locked = server.session_lock.lock;
 	struct sway_keyboard_shortcuts_inhibitor *sway_inhibitor =
 		keyboard_shortcuts_inhibitor_get_for_focused_surface(seat);
@@ -452,21 +638,26 @@ static void handle_key_event(struct sway_keyboard *keyboard,
 	struct key_info keyinfo;
 	update_keyboard_state(keyboard, event->keycode, event->state, &keyinfo);
 
+	struct sway_binding_index *keycode_index =
+		mode_get_binding_index(config->current_mode, BINDING_KEYCODE);
+	struct sway_binding_index *keysym_index =
+		mode_get_binding_index(config->current_mode, BINDING_KEYSYM);
+
 	bool handled = false;
 	// Identify active release binding
 	struct sway_binding *binding_released = NULL;
 	get_active_binding(&keyboard->state_keycodes,
-			config->current_mode->keycode_bindings, &binding_released,
+			keycode_index, &binding_released,
 			keyinfo.code_modifiers, true, locked,
 			shortcuts_inhibited, device_identifier,
 			exact_identifier, keyboard->effective_layout);
 	get_active_binding(&keyboard->state_keysyms_raw,
-			config->current_mode->keysym_bindings, &binding_released,
+			keysym_index, &binding_released,
 			keyinfo.raw_modifiers, true, locked,
 			shortcuts_inhibited, device_identifier,
 			exact_identifier, keyboard->effective_layout);
 	get_active_binding(&keyboard->state_keysyms_translated,
-			config->current_mode->keysym_bindings, &binding_released,
+			keysym_index, &binding_released,
 			keyinfo.translated_modifiers, true, locked,
 			shortcuts_inhibited, device_identifier,
 			exact_identifier, keyboard->effective_layout);
@@ -488,17 +679,17 @@ static void handle_key_event(struct sway_keyboard *keyboard,
 	struct sway_binding *binding = NULL;
 	if (event->state == WL_KEYBOARD_KEY_STATE_PRESSED) {
 		get_active_binding(&keyboard->state_keycodes,
-				config->current_mode->keycode_bindings, &binding,
+				keycode_index, &binding,
 				keyinfo.code_modifiers, false, locked,
 				shortcuts_inhibited, device_identifier,
 				exact_identifier, keyboard->effective_layout);
 		get_active_binding(&keyboard->state_keysyms_raw,
-				config->current_mode->keysym_bindings, &binding,
+				keysym_index, &binding,
 				keyinfo.raw_modifiers, false, locked,
 				shortcuts_inhibited, device_identifier,
 				exact_identifier, keyboard->effective_layout);
 		get_active_binding(&keyboard->state_keysyms_translated,
-				config->current_mode->keysym_bindings, &binding,
+				keysym_index, &binding,
 				keyinfo.translated_modifiers, false, locked,
 				shortcuts_inhibited, device_identifier,
 				exact_identifier, keyboard->effective_layout);
@@ -50,9 +50,33 @@ static void seat_device_destroy(struct sway_seat_device *seat_device) {
 	free(seat_device);
 }
 
+// Incremented whenever nodes are added to or removed from a focus stack, or a
+// focus stack is reordered other than by seat_set_raw_focus
+static uint64_t focus_generation = 0;
+
+static bool focus_cache_get(struct sway_focus_cache *cache,
+		struct sway_seat *seat, struct sway_node **node) {
+	if (cache->seat != seat ||
+			cache->tree_generation != root->tree_generation ||
+			cache->focus_generation != focus_generation) {
+		return false;
+	}
+	*node = cache->node;
+	return true;
+}
+
+static void focus_cache_set(struct sway_focus_cache *cache,
+		struct sway_seat *seat, struct sway_node *node) {
+	cache->seat = seat;
+	cache->tree_generation = root->tree_generation;
+	cache->focus_generation = focus_generation;
+	cache->node = node;
+}
+
 static void seat_node_destroy(struct sway_seat_node *seat_node) {
 	wl_list_remove(&seat_node->destroy.link);
 	wl_list_remove(&seat_node->link);
+	focus_generation++;
 
 	/*
 	 * This is the only time we remove items from the focus stack without
@@ -347,6 +371,7 @@ static struct sway_seat_node *seat_node_from_node(
 	seat_node->node = node;
 	seat_node->seat = seat;
 	wl_list_insert(seat->focus_stack.prev, &seat_node->link);
+	focus_generation++;
 	wl_signal_add(&node->events.destroy, &seat_node->destroy);
 	seat_node->destroy.notify = handle_seat_node_destroy;
 
@@ -497,6 +522,7 @@ static void collect_focus_iter(struct sway_node *node, void *data) {
 	}
 	wl_list_remove(&seat_node->link);
 	wl_list_insert(&seat->focus_stack, &seat_node->link);
+	focus_generation++;
 }
 
 static void collect_focus_workspace_iter(struct sway_workspace *workspace,
@@ -1113,10 +1139,43 @@ static void set_workspace(struct sway_seat *seat,
 	seat->workspace = new_ws;
 }
 
+/**
+ * The node has just been moved to the top of the seat's focus stack, which
+ * makes it the answer to every focus query that it matches.
+ */
+static void seat_update_focus_caches(struct sway_seat *seat,
+		struct sway_node *node) {
+	struct sway_node *parent = node_get_parent(node);
+	if (parent && (parent->type != N_WORKSPACE ||
+			list_find(parent->sway_workspace->tiling, node->sway_container) != -1)) {
+		focus_cache_set(&parent->active_tiling_child, seat, node);
+	}
+
+	for (struct sway_node *ancestor = parent; ancestor;
+			ancestor = node_get_parent(ancestor)) {
+		focus_cache_set(&ancestor->focus_inactive, seat, node);
+	}
+	// A global fullscreen container counts as a descendant of the root even
+	// if it's not in the tree
+	if (node_has_ancestor(node, &root->node)) {
+		focus_cache_set(&root->node.focus_inactive, seat, node);
+	}
+
+	if (node->type == N_CONTAINER && node->sway_container->pending.workspace) {
+		struct sway_workspace *ws = node->sway_container->pending.workspace;
+		if (container_is_floating_or_child(node->sway_container)) {
+			focus_cache_set(&ws->focus_inactive_floating, seat, node);
+		} else {
+			focus_cache_set(&ws->focus_inactive_tiling, seat, node);
+		}
+	}
+}
+
 void seat_set_raw_focus(struct sway_seat *seat, struct sway_node *node) {
 	struct sway_seat_node *seat_node = seat_node_from_node(seat, node);
 	wl_list_remove(&seat_node->link);
 	wl_list_insert(&seat->focus_stack, &seat_node->link);
+	seat_update_focus_caches(seat, node);
 	node_set_dirty(node);
 
 	// If focusing a scratchpad container that is fullscreen global, parent
@@ -1363,16 +1422,22 @@ struct sway_node *seat_get_focus_inactive(struct sway_seat *seat,
 	if (node_is_view(node)) {
 		return node;
 	}
+	struct sway_node *result = NULL;
+	if (focus_cache_get(&node->focus_inactive, seat, &result)) {
+		return result;
+	}
 	struct sway_seat_node *current;
 	wl_list_for_each(current, &seat->focus_stack, link) {
 		if (node_has_ancestor(current->node, node)) {
-			return current->node;
+			result = current->node;
+			break;
 		}
 	}
-	if (node->type == N_WORKSPACE) {
-		return node;
+	if (!result && node->type == N_WORKSPACE) {
+		result = node;
 	}
-	return NULL;
+	focus_cache_set(&node->focus_inactive, seat, result);
+	return result;
 }
 
 struct sway_container *seat_get_focus_inactive_tiling(struct sway_seat *seat,
@@ -1380,16 +1445,22 @@ struct sway_container *seat_get_focus_inactive_tiling(struct sway_seat *seat,
 	if (!workspace->tiling->length) {
 		return NULL;
 	}
+	struct sway_node *result = NULL;
+	if (focus_cache_get(&workspace->focus_inactive_tiling, seat, &result)) {
+		return result ? result->sway_container : NULL;
+	}
 	struct sway_seat_node *current;
 	wl_list_for_each(current, &seat->focus_stack, link) {
 		struct sway_node *node = current->node;
 		if (node->type == N_CONTAINER &&
 				!container_is_floating_or_child(node->sway_container) &&
 				node->sway_container->pending.workspace == workspace) {
-			return node->sway_container;
+			result = node;
+			break;
 		}
 	}
-	return NULL;
+	focus_cache_set(&workspace->focus_inactive_tiling, seat, result);
+	return result ? result->sway_container : NULL;
 }
 
 struct sway_container *seat_get_focus_inactive_floating(struct sway_seat *seat,
@@ -1397,16 +1468,22 @@ struct sway_container *seat_get_focus_inactive_floating(struct sway_seat *seat,
 	if (!workspace->floating->length) {
 		return NULL;
 	}
+	struct sway_node *result = NULL;
+	if (focus_cache_get(&workspace->focus_inactive_floating, seat, &result)) {
+		return result ? result->sway_container : NULL;
+	}
 	struct sway_seat_node *current;
 	wl_list_for_each(current, &seat->focus_stack, link) {
 		struct sway_node *node = current->node;
 		if (node->type == N_CONTAINER &&
 				container_is_floating_or_child(node->sway_container) &&
 				node->sway_container->pending.workspace == workspace) {
-			return node->sway_container;
+			result = node;
+			break;
 		}
 	}
-	return NULL;
+	focus_cache_set(&workspace->focus_inactive_floating, seat, result);
+	return result ? result->sway_container : NULL;
 }
 
 struct sway_node *seat_get_active_tiling_child(struct sway_seat *seat,
@@ -1414,6 +1491,10 @@ struct sway_node *seat_get_active_tiling_child(struct sway_seat *seat,
 	if (node_is_view(parent)) {
 		return parent;
 	}
+	struct sway_node *result = NULL;
+	if (focus_cache_get(&parent->active_tiling_child, seat, &result)) {
+		return result;
+	}
 	struct sway_seat_node *current;
 	wl_list_for_each(current, &seat->focus_stack, link) {
 		struct sway_node *node = current->node;
@@ -1427,9 +1508,11 @@ struct sway_node *seat_get_active_tiling_child(struct sway_seat *seat,
 				continue;
 			}
 		}
-		return node;
+		result = node;
+		break;
 	}
-	return NULL;
+	focus_cache_set(&parent->active_tiling_child, seat, result);
+	return result;
 }
 
 struct sway_node *seat_get_focus(struct sway_seat *seat) {
@@ -1490,6 +1573,12 @@ void seat_apply_config(struct sway_seat *seat,
 	seat->idle_inhibit_sources = seat_config->idle_inhibit_sources;
 	seat->idle_wake_sources = seat_config->idle_wake_sources;
 
+	seat->cursor->motion_batching =
+		seat_config->pointer_batching == POINTER_BATCHING_ENABLE;
+	if (!seat->cursor->motion_batching) {
+		cursor_flush_motion(seat->cursor);
+	}
+
 	wl_list_for_each(seat_device, &seat->devices, link) {
 		seat_configure_device(seat, seat_device->input_device);
 		cursor_handle_activity_from_device(seat->cursor,
@@ -1560,6 +1649,7 @@ void seatop_unref(struct sway_seat *seat, struct sway_container *con) {
 void seatop_button(struct sway_seat *seat, uint32_t time_msec,
 		struct wlr_input_device *device, uint32_t button,
 		enum wl_pointer_button_state state) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->button) {
 		seat->seatop_impl->button(seat, time_msec, device, button, state);
 	}
@@ -1573,6 +1663,7 @@ void seatop_pointer_motion(struct sway_seat *seat, uint32_t time_msec) {
 
 void seatop_pointer_axis(struct sway_seat *seat,
 		struct wlr_pointer_axis_event *event) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->pointer_axis) {
 		seat->seatop_impl->pointer_axis(seat, event);
 	}
@@ -1580,12 +1671,14 @@ void seatop_pointer_axis(struct sway_seat *seat,
 
 void seatop_touch_motion(struct sway_seat *seat, struct wlr_touch_motion_event *event,
 		double lx, double ly) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->touch_motion) {
 		seat->seatop_impl->touch_motion(seat, event, lx, ly);
 	}
 }
 
 void seatop_touch_up(struct sway_seat *seat, struct wlr_touch_up_event *event) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->touch_up) {
 		seat->seatop_impl->touch_up(seat, event);
 	}
@@ -1593,12 +1686,14 @@ void seatop_touch_up(struct sway_seat *seat, struct wlr_touch_up_event *event) {
 
 void seatop_touch_down(struct sway_seat *seat, struct wlr_touch_down_event *event,
 		double lx, double ly) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->touch_down) {
 		seat->seatop_impl->touch_down(seat, event, lx, ly);
 	}
 }
 
 void seatop_touch_cancel(struct sway_seat *seat, struct wlr_touch_cancel_event *event) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->touch_cancel) {
 		seat->seatop_impl->touch_cancel(seat, event);
 	}
@@ -1607,6 +1702,7 @@ void seatop_touch_cancel(struct sway_seat *seat, struct wlr_touch_cancel_event *
 void seatop_tablet_tool_tip(struct sway_seat *seat,
 		struct sway_tablet_tool *tool, uint32_t time_msec,
 		enum wlr_tablet_tool_tip_state state) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->tablet_tool_tip) {
 		seat->seatop_impl->tablet_tool_tip(seat, tool, time_msec, state);
 	}
@@ -1614,6 +1710,7 @@ void seatop_tablet_tool_tip(struct sway_seat *seat,
 
 void seatop_tablet_tool_motion(struct sway_seat *seat,
 		struct sway_tablet_tool *tool, uint32_t time_msec) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->tablet_tool_motion) {
 		seat->seatop_impl->tablet_tool_motion(seat, tool, time_msec);
 	} else {
@@ -1623,6 +1720,7 @@ void seatop_tablet_tool_motion(struct sway_seat *seat,
 
 void seatop_hold_begin(struct sway_seat *seat,
 		struct wlr_pointer_hold_begin_event *event) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->hold_begin) {
 		seat->seatop_impl->hold_begin(seat, event);
 	}
@@ -1630,6 +1728,7 @@ void seatop_hold_begin(struct sway_seat *seat,
 
 void seatop_hold_end(struct sway_seat *seat,
 		struct wlr_pointer_hold_end_event *event) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->hold_end) {
 		seat->seatop_impl->hold_end(seat, event);
 	}
@@ -1637,6 +1736,7 @@ void seatop_hold_end(struct sway_seat *seat,
 
 void seatop_pinch_begin(struct sway_seat *seat,
 		struct wlr_pointer_pinch_begin_event *event) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->pinch_begin) {
 		seat->seatop_impl->pinch_begin(seat, event);
 	}
@@ -1644,6 +1744,7 @@ void seatop_pinch_begin(struct sway_seat *seat,
 
 void seatop_pinch_update(struct sway_seat *seat,
 		struct wlr_pointer_pinch_update_event *event) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->pinch_update) {
 		seat->seatop_impl->pinch_update(seat, event);
 	}
@@ -1651,6 +1752,7 @@ void seatop_pinch_update(struct sway_seat *seat,
 
 void seatop_pinch_end(struct sway_seat *seat,
 		struct wlr_pointer_pinch_end_event *event) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->pinch_end) {
 		seat->seatop_impl->pinch_end(seat, event);
 	}
@@ -1658,6 +1760,7 @@ void seatop_pinch_end(struct sway_seat *seat,
 
 void seatop_swipe_begin(struct sway_seat *seat,
 		struct wlr_pointer_swipe_begin_event *event) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->swipe_begin) {
 		seat->seatop_impl->swipe_begin(seat, event);
 	}
@@ -1665,6 +1768,7 @@ void seatop_swipe_begin(struct sway_seat *seat,
 
 void seatop_swipe_update(struct sway_seat *seat,
 		struct wlr_pointer_swipe_update_event *event) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->swipe_update) {
 		seat->seatop_impl->swipe_update(seat, event);
 	}
@@ -1672,12 +1776,14 @@ void seatop_swipe_update(struct sway_seat *seat,
 
 void seatop_swipe_end(struct sway_seat *seat,
 		struct wlr_pointer_swipe_end_event *event) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->swipe_end) {
 		seat->seatop_impl->swipe_end(seat, event);
 	}
 }
 
 void seatop_rebase(struct sway_seat *seat, uint32_t time_msec) {
+	cursor_flush_motion(seat->cursor);
 	if (seat->seatop_impl->rebase) {
 		seat->seatop_impl->rebase(seat, time_msec);
 	}
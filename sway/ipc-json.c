@@ -2,7 +2,10 @@
 #include <float.h>
 #include <json.h>
 #include <libevdev/libevdev.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <wlr/config.h>
 #include <wlr/types/wlr_content_type_v1.h>
 #include <wlr/types/wlr_output.h>
@@ -10,6 +13,7 @@
 #include <xkbcommon/xkbcommon.h>
 #include "config.h"
 #include "log.h"
+#include "stringop.h"
 #include "sway/config.h"
 #include "sway/ipc-json.h"
 #include "sway/server.h"
@@ -27,10 +31,10 @@
 #include <wlr/backend/libinput.h>
 #endif
 
-static const int i3_output_id = INT32_MAX;
-static const int i3_scratch_id = INT32_MAX - 1;
+const int i3_output_id = INT32_MAX;
+const int i3_scratch_id = INT32_MAX - 1;
 
-static const char *ipc_json_node_type_description(enum sway_node_type node_type) {
+const char *ipc_json_node_type_description(enum sway_node_type node_type) {
 	switch (node_type) {
 	case N_ROOT:
 		return "root";
@@ -44,7 +48,7 @@ static const char *ipc_json_node_type_description(enum sway_node_type node_type)
 	return "none";
 }
 
-static const char *ipc_json_layout_description(enum sway_container_layout l) {
+const char *ipc_json_layout_description(enum sway_container_layout l) {
 	switch (l) {
 	case L_VERT:
 		return "splitv";
@@ -238,6 +242,149 @@ json_object *ipc_json_get_version(void) {
 	return version;
 }
 
+/**
+ * A set of requested fields, stored as a tree of path components. A field
+ * without children includes everything below it.
+ */
+struct ipc_json_fields {
+	char *name; // NULL for the root
+	list_t *children; // struct ipc_json_fields *
+};
+
+// The fields to include in descriptions, or NULL for all of them
+static struct ipc_json_fields *active_fields = NULL;
+
+static struct ipc_json_fields *fields_create(const char *name, size_t len) {
+	struct ipc_json_fields *fields = calloc(1, sizeof(*fields));
+	if (!fields) {
+		return NULL;
+	}
+	fields->name = name ? strndup(name, len) : NULL;
+	fields->children = create_list();
+	return fields;
+}
+
+void ipc_json_fields_destroy(struct ipc_json_fields *fields) {
+	if (!fields) {
+		return;
+	}
+	for (int i = 0; i < fields->children->length; ++i) {
+		ipc_json_fields_destroy(fields->children->items[i]);
+	}
+	list_free(fields->children);
+	free(fields->name);
+	free(fields);
+}
+
+static struct ipc_json_fields *fields_find(struct ipc_json_fields *fields,
+		const char *name, size_t len) {
+	for (int i = 0; i < fields->children->length; ++i) {
+		struct ipc_json_fields *child = fields->children->items[i];
+		if (strlen(child->name) == len && strncmp(child->name, name, len) == 0) {
+			return child;
+		}
+	}
+	return NULL;
+}
+
+static void fields_add_path(struct ipc_json_fields *fields, const char *path) {
+	while (true) {
+		size_t len = strcspn(path, ".");
+		struct ipc_json_fields *child = fields_find(fields, path, len);
+		bool last = path[len] == '\0';
+		if (!child) {
+			child = fields_create(path, len);
+			list_add(fields->children, child);
+		} else if (child->children->length == 0) {
+			// Already included as a whole
+			return;
+		}
+		if (last) {
+			// Include everything below it
+			while (child->children->length) {
+				ipc_json_fields_destroy(child->children->items[0]);
+				list_del(child->children, 0);
+			}
+			return;
+		}
+		fields = child;
+		path += len + 1;
+	}
+}
+
+struct ipc_json_fields *ipc_json_fields_parse(json_object *array,
+		char **error) {
+	if (!json_object_is_type(array, json_type_array)) {
+		*error = strdup("fields must be an array of strings");
+		return NULL;
+	}
+	struct ipc_json_fields *fields = fields_create(NULL, 0);
+	for (size_t i = 0; i < json_object_array_length(array); ++i) {
+		json_object *item = json_object_array_get_idx(array, i);
+		const char *path = json_object_get_string(item);
+		if (!json_object_is_type(item, json_type_string) || !path[0] ||
+				path[0] == '.' || path[strlen(path) - 1] == '.' ||
+				strstr(path, "..")) {
+			*error = format_str("Invalid field '%s'",
+				json_object_to_json_string(item));
+			ipc_json_fields_destroy(fields);
+			return NULL;
+		}
+		fields_add_path(fields, path);
+	}
+	return fields;
+}
+
+void ipc_json_fields_add(struct ipc_json_fields *fields, const char *path) {
+	if (fields->children->length) {
+		fields_add_path(fields, path);
+	}
+}
+
+void ipc_json_set_fields(struct ipc_json_fields *fields) {
+	active_fields = fields;
+}
+
+bool ipc_json_field_wanted(const char *name) {
+	return !active_fields || active_fields->children->length == 0 ||
+		fields_find(active_fields, name, strlen(name));
+}
+
+static void fields_project(struct ipc_json_fields *fields, json_object *object) {
+	if (fields->children->length == 0) {
+		return;
+	}
+	if (json_object_is_type(object, json_type_array)) {
+		for (size_t i = 0; i < json_object_array_length(object); ++i) {
+			fields_project(fields, json_object_array_get_idx(object, i));
+		}
+		return;
+	}
+	if (!json_object_is_type(object, json_type_object)) {
+		return;
+	}
+
+	list_t *unwanted = create_list();
+	json_object_object_foreach(object, key, value) {
+		struct ipc_json_fields *child = fields_find(fields, key, strlen(key));
+		if (!child) {
+			list_add(unwanted, key);
+		} else if (value) {
+			fields_project(child, value);
+		}
+	}
+	for (int i = 0; i < unwanted->length; ++i) {
+		json_object_object_del(object, unwanted->items[i]);
+	}
+	list_free(unwanted);
+}
+
+void ipc_json_project(json_object *object) {
+	if (active_fields) {
+		fields_project(active_fields, object);
+	}
+}
+
 static json_object *ipc_json_create_rect(struct wlr_box *box) {
 	json_object *rect = json_object_new_object();
 
@@ -410,6 +557,13 @@ static void ipc_json_describe_enabled_output(struct sway_output *output,
 	json_object_object_add(object, "max_render_time", json_object_new_int(output->max_render_time));
 	json_object_object_add(object, "allow_tearing", json_object_new_boolean(output->allow_tearing));
 	json_object_object_add(object, "hdr", json_object_new_boolean(output->hdr));
+
+	json_object *configure_stats = json_object_new_object();
+	json_object_object_add(configure_stats, "nodes_visited",
+		json_object_new_int64(output->configure_stats.nodes_visited));
+	json_object_object_add(configure_stats, "subtrees_skipped",
+		json_object_new_int64(output->configure_stats.subtrees_skipped));
+	json_object_object_add(object, "scene_configure", configure_stats);
 }
 
 json_object *ipc_json_describe_disabled_output(struct sway_output *output) {
@@ -482,6 +636,7 @@ static json_object *ipc_json_describe_scratchpad_output(void) {
 		}
 	}
 	json_object_object_add(workspace, "floating_nodes", floating_array);
+	ipc_json_project(workspace);
 
 	// Create focus stack for __i3 output
 	json_object *output_focus = json_object_new_array();
@@ -491,6 +646,7 @@ static json_object *ipc_json_describe_scratchpad_output(void) {
 					"__i3", false, output_focus, &box);
 	json_object_object_add(output, "layout",
 			json_object_new_string("output"));
+	ipc_json_project(output);
 
 	json_object *nodes = json_object_new_array();
 	json_object_array_add(nodes, workspace);
@@ -530,6 +686,10 @@ static void ipc_json_describe_workspace(struct sway_workspace *workspace,
 			json_object_new_string(
 				ipc_json_orientation_description(workspace->layout)));
 
+	if (!ipc_json_field_wanted("floating_nodes")) {
+		return;
+	}
+
 	// Floating
 	json_object *floating_array = json_object_new_array();
 	for (int i = 0; i < workspace->floating->length; ++i) {
@@ -579,6 +739,35 @@ static void get_deco_rect(struct sway_container *c, struct wlr_box *deco_rect) {
 	}
 }
 
+static json_object *ipc_json_describe_idle_inhibitors(struct sway_view *view) {
+	json_object *idle_inhibitors = json_object_new_object();
+
+	struct sway_idle_inhibitor_v1 *user_inhibitor =
+		sway_idle_inhibit_v1_user_inhibitor_for_view(view);
+
+	if (user_inhibitor) {
+		json_object_object_add(idle_inhibitors, "user",
+			json_object_new_string(
+				ipc_json_user_idle_inhibitor_description(user_inhibitor->mode)));
+	} else {
+		json_object_object_add(idle_inhibitors, "user",
+			json_object_new_string("none"));
+	}
+
+	struct sway_idle_inhibitor_v1 *application_inhibitor =
+		sway_idle_inhibit_v1_application_inhibitor_for_view(view);
+
+	if (application_inhibitor) {
+		json_object_object_add(idle_inhibitors, "application",
+			json_object_new_string("enabled"));
+	} else {
+		json_object_object_add(idle_inhibitors, "application",
+			json_object_new_string("none"));
+	}
+
+	return idle_inhibitors;
+}
+
 static void ipc_json_describe_view(struct sway_container *c, json_object *object) {
 	json_object_object_add(object, "pid", json_object_new_int(c->view->pid));
 
@@ -590,8 +779,10 @@ static void ipc_json_describe_view(struct sway_container *c, json_object *object
 		c->view->ext_foreign_toplevel ?
 			json_object_new_string(c->view->ext_foreign_toplevel->identifier) : NULL);
 
-	bool visible = view_is_visible(c->view);
-	json_object_object_add(object, "visible", json_object_new_boolean(visible));
+	if (ipc_json_field_wanted("visible")) {
+		bool visible = view_is_visible(c->view);
+		json_object_object_add(object, "visible", json_object_new_boolean(visible));
+	}
 
 	bool has_titlebar = c->title_bar.tree->node.enabled;
 	struct wlr_box window_box = {
@@ -612,51 +803,37 @@ static void ipc_json_describe_view(struct sway_container *c, json_object *object
 
 	json_object_object_add(object, "shell", json_object_new_string(view_get_shell(c->view)));
 
-	json_object_object_add(object, "inhibit_idle",
-		json_object_new_boolean(view_inhibit_idle(c->view)));
+	if (ipc_json_field_wanted("inhibit_idle")) {
+		json_object_object_add(object, "inhibit_idle",
+			json_object_new_boolean(view_inhibit_idle(c->view)));
+	}
 
-	const char *sandbox_engine = view_get_sandbox_engine(c->view);
-	json_object_object_add(object, "sandbox_engine",
-			sandbox_engine ? json_object_new_string(sandbox_engine) : NULL);
+	if (ipc_json_field_wanted("sandbox_engine")) {
+		const char *sandbox_engine = view_get_sandbox_engine(c->view);
+		json_object_object_add(object, "sandbox_engine",
+				sandbox_engine ? json_object_new_string(sandbox_engine) : NULL);
+	}
 
-	const char *sandbox_app_id = view_get_sandbox_app_id(c->view);
-	json_object_object_add(object, "sandbox_app_id",
-			sandbox_app_id ? json_object_new_string(sandbox_app_id) : NULL);
+	if (ipc_json_field_wanted("sandbox_app_id")) {
+		const char *sandbox_app_id = view_get_sandbox_app_id(c->view);
+		json_object_object_add(object, "sandbox_app_id",
+				sandbox_app_id ? json_object_new_string(sandbox_app_id) : NULL);
+	}
 
-	const char *sandbox_instance_id = view_get_sandbox_instance_id(c->view);
-	json_object_object_add(object, "sandbox_instance_id",
-			sandbox_instance_id ? json_object_new_string(sandbox_instance_id) : NULL);
+	if (ipc_json_field_wanted("sandbox_instance_id")) {
+		const char *sandbox_instance_id = view_get_sandbox_instance_id(c->view);
+		json_object_object_add(object, "sandbox_instance_id",
+				sandbox_instance_id ? json_object_new_string(sandbox_instance_id) : NULL);
+	}
 
 	const char *tag = view_get_tag(c->view);
 	json_object_object_add(object, "tag", tag ? json_object_new_string(tag) : NULL);
 
-	json_object *idle_inhibitors = json_object_new_object();
-
-	struct sway_idle_inhibitor_v1 *user_inhibitor =
-		sway_idle_inhibit_v1_user_inhibitor_for_view(c->view);
-
-	if (user_inhibitor) {
-		json_object_object_add(idle_inhibitors, "user",
-			json_object_new_string(
-				ipc_json_user_idle_inhibitor_description(user_inhibitor->mode)));
-	} else {
-		json_object_object_add(idle_inhibitors, "user",
-			json_object_new_string("none"));
-	}
-
-	struct sway_idle_inhibitor_v1 *application_inhibitor =
-		sway_idle_inhibit_v1_application_inhibitor_for_view(c->view);
-
-	if (application_inhibitor) {
-		json_object_object_add(idle_inhibitors, "application",
-			json_object_new_string("enabled"));
-	} else {
-		json_object_object_add(idle_inhibitors, "application",
-			json_object_new_string("none"));
+	if (ipc_json_field_wanted("idle_inhibitors")) {
+		json_object_object_add(object, "idle_inhibitors",
+			ipc_json_describe_idle_inhibitors(c->view));
 	}
 
-	json_object_object_add(object, "idle_inhibitors", idle_inhibitors);
-
 	enum wp_content_type_v1_type content_type = WP_CONTENT_TYPE_V1_TYPE_NONE;
 	if (c->view->surface != NULL) {
 		content_type = wlr_surface_get_content_type_v1(server.content_type_manager_v1,
@@ -765,19 +942,36 @@ static void ipc_json_describe_container(struct sway_container *c, json_object *o
 	get_deco_rect(c, &deco_box);
 	json_object_object_add(object, "deco_rect", ipc_json_create_rect(&deco_box));
 
-	json_object *marks = json_object_new_array();
-	list_t *con_marks = c->marks;
-	for (int i = 0; i < con_marks->length; ++i) {
-		json_object_array_add(marks, json_object_new_string(con_marks->items[i]));
-	}
+	if (ipc_json_field_wanted("marks")) {
+		json_object *marks = json_object_new_array();
+		list_t *con_marks = c->marks;
+		for (int i = 0; i < con_marks->length; ++i) {
+			json_object_array_add(marks, json_object_new_string(con_marks->items[i]));
+		}
 
-	json_object_object_add(object, "marks", marks);
+		json_object_object_add(object, "marks", marks);
+	}
 
 	if (c->view) {
 		ipc_json_describe_view(c, object);
 	}
 }
 
+static void focus_array_add_output(json_object *focus, struct sway_node *node) {
+	struct sway_output *output = node_get_output(node);
+	if (output == NULL) {
+		return;
+	}
+	size_t id = output->node.id;
+	int len = json_object_array_length(focus);
+	for (int i = 0; i < len; ++i) {
+		if ((size_t) json_object_get_int(json_object_array_get_idx(focus, i)) == id) {
+			return;
+		}
+	}
+	json_object_array_add(focus, json_object_new_int(id));
+}
+
 struct focus_inactive_data {
 	struct sway_node *node;
 	json_object *object;
@@ -788,40 +982,101 @@ static void focus_inactive_children_iterator(struct sway_node *node,
 	struct focus_inactive_data *data = _data;
 	json_object *focus = data->object;
 	if (data->node == &root->node) {
-		struct sway_output *output = node_get_output(node);
-		if (output == NULL) {
-			return;
-		}
-		size_t id = output->node.id;
-		int len = json_object_array_length(focus);
-		for (int i = 0; i < len; ++i) {
-			if ((size_t) json_object_get_int(json_object_array_get_idx(focus, i)) == id) {
-				return;
-			}
-		}
-		node = &output->node;
+		focus_array_add_output(focus, node);
+		return;
 	} else if (node_get_parent(node) != data->node) {
 		return;
 	}
 	json_object_array_add(focus, json_object_new_int(node->id));
 }
 
-json_object *ipc_json_describe_node(struct sway_node *node) {
-	struct sway_seat *seat = input_manager_get_default_seat();
-	bool focused = seat_get_focus(seat) == node;
-	char *name = node_get_name(node);
+struct focus_map_entry {
+	struct sway_node *parent;
+	json_object *focus;
+};
 
-	struct wlr_box box;
-	node_get_box(node, &box);
-	if (node->type == N_CONTAINER) {
-		struct wlr_box deco_rect = {0, 0, 0, 0};
-		get_deco_rect(node->sway_container, &deco_rect);
-		size_t count = 1;
-		if (container_parent_layout(node->sway_container) == L_STACKED) {
-			count = container_get_siblings(node->sway_container)->length;
+/**
+ * The focus arrays of all nodes, built with a single pass over the seat's
+ * focus stack while a whole tree is described. Without it every node walks the
+ * entire focus stack to find its own children.
+ */
+struct focus_map {
+	struct focus_map_entry *entries;
+	size_t capacity; // power of two
+};
+
+static struct focus_map *focus_map = NULL;
+
+static struct focus_map_entry *focus_map_find(struct focus_map *map,
+		struct sway_node *parent, bool create) {
+	size_t mask = map->capacity - 1;
+	size_t i = ((uintptr_t)parent >> 4) * 0x9e3779b1u & mask;
+	for (;; i = (i + 1) & mask) {
+		struct focus_map_entry *entry = &map->entries[i];
+		if (!entry->parent) {
+			if (!create) {
+				return NULL;
+			}
+			entry->parent = parent;
+			entry->focus = json_object_new_array();
+			return entry;
 		}
-		box.y += deco_rect.height * count;
-		box.height -= deco_rect.height * count;
+		if (entry->parent == parent) {
+			return entry;
+		}
+	}
+}
+
+static struct focus_map *focus_map_create(struct sway_seat *seat) {
+	struct focus_map *map = calloc(1, sizeof(*map));
+	if (!map) {
+		return NULL;
+	}
+	// Keep the load factor at or below one half
+	size_t len = wl_list_length(&seat->focus_stack) + 1;
+	map->capacity = 8;
+	while (map->capacity < len * 2) {
+		map->capacity *= 2;
+	}
+	map->entries = calloc(map->capacity, sizeof(*map->entries));
+	if (!map->entries) {
+		free(map);
+		return NULL;
+	}
+
+	json_object *root_focus = focus_map_find(map, &root->node, true)->focus;
+	struct sway_seat_node *current;
+	wl_list_for_each(current, &seat->focus_stack, link) {
+		struct sway_node *node = current->node;
+		focus_array_add_output(root_focus, node);
+		struct sway_node *parent = node_get_parent(node);
+		if (parent && parent != &root->node) {
+			json_object_array_add(focus_map_find(map, parent, true)->focus,
+				json_object_new_int(node->id));
+		}
+	}
+	return map;
+}
+
+static void focus_map_destroy(struct focus_map *map) {
+	for (size_t i = 0; i < map->capacity; ++i) {
+		json_object_put(map->entries[i].focus);
+	}
+	free(map->entries);
+	free(map);
+}
+
+static json_object *describe_node_focus(struct sway_seat *seat,
+		struct sway_node *node) {
+	if (focus_map) {
+		struct focus_map_entry *entry = focus_map_find(focus_map, node, false);
+		if (!entry || !entry->focus) {
+			return json_object_new_array();
+		}
+		// Each node is described once, so hand over the array
+		json_object *focus = entry->focus;
+		entry->focus = NULL;
+		return focus;
 	}
 
 	json_object *focus = json_object_new_array();
@@ -830,6 +1085,33 @@ json_object *ipc_json_describe_node(struct sway_node *node) {
 		.object = focus,
 	};
 	seat_for_each_node(seat, focus_inactive_children_iterator, &data);
+	return focus;
+}
+
+void ipc_json_get_node_rect(struct sway_node *node, struct wlr_box *box) {
+	node_get_box(node, box);
+	if (node->type == N_CONTAINER) {
+		struct wlr_box deco_rect = {0, 0, 0, 0};
+		get_deco_rect(node->sway_container, &deco_rect);
+		size_t count = 1;
+		if (container_parent_layout(node->sway_container) == L_STACKED) {
+			count = container_get_siblings(node->sway_container)->length;
+		}
+		box->y += deco_rect.height * count;
+		box->height -= deco_rect.height * count;
+	}
+}
+
+json_object *ipc_json_describe_node(struct sway_node *node) {
+	struct sway_seat *seat = input_manager_get_default_seat();
+	bool focused = seat_get_focus(seat) == node;
+	char *name = node_get_name(node);
+
+	struct wlr_box box;
+	ipc_json_get_node_rect(node, &box);
+
+	json_object *focus = ipc_json_field_wanted("focus") ?
+		describe_node_focus(seat, node) : NULL;
 
 	json_object *object = ipc_json_create_node((int)node->id,
 				ipc_json_node_type_description(node->type), name, focused, focus, &box);
@@ -848,10 +1130,17 @@ json_object *ipc_json_describe_node(struct sway_node *node) {
 		break;
 	}
 
+	ipc_json_project(object);
 	return object;
 }
 
 json_object *ipc_json_describe_node_recursive(struct sway_node *node) {
+	// Collect the focus arrays of the whole subtree up front
+	struct focus_map *map = NULL;
+	if (!focus_map && ipc_json_field_wanted("focus")) {
+		map = focus_map = focus_map_create(input_manager_get_default_seat());
+	}
+
 	json_object *object = ipc_json_describe_node(node);
 	int i;
 
@@ -893,9 +1182,94 @@ json_object *ipc_json_describe_node_recursive(struct sway_node *node) {
 	}
 	json_object_object_add(object, "nodes", children);
 
+	if (map) {
+		focus_map_destroy(map);
+		focus_map = NULL;
+	}
 	return object;
 }
 
+static void write_node_children(struct ipc_json_buffer *buf,
+		struct sway_node *node) {
+	ipc_json_write_array_begin(buf);
+	switch (node->type) {
+	case N_ROOT:
+		ipc_json_write_array_item(buf);
+		json_object *scratchpad = ipc_json_describe_scratchpad_output();
+		ipc_json_write(buf, scratchpad);
+		json_object_put(scratchpad);
+		for (int i = 0; i < root->outputs->length; ++i) {
+			struct sway_output *output = root->outputs->items[i];
+			ipc_json_write_array_item(buf);
+			ipc_json_write_node_recursive(buf, &output->node, NULL, NULL);
+		}
+		break;
+	case N_OUTPUT:
+		for (int i = 0; i < node->sway_output->workspaces->length; ++i) {
+			struct sway_workspace *ws = node->sway_output->workspaces->items[i];
+			ipc_json_write_array_item(buf);
+			ipc_json_write_node_recursive(buf, &ws->node, NULL, NULL);
+		}
+		break;
+	case N_WORKSPACE:
+		for (int i = 0; i < node->sway_workspace->tiling->length; ++i) {
+			struct sway_container *con = node->sway_workspace->tiling->items[i];
+			ipc_json_write_array_item(buf);
+			ipc_json_write_node_recursive(buf, &con->node, NULL, NULL);
+		}
+		break;
+	case N_CONTAINER:
+		if (node->sway_container->pending.children) {
+			list_t *children = node->sway_container->pending.children;
+			for (int i = 0; i < children->length; ++i) {
+				struct sway_container *child = children->items[i];
+				ipc_json_write_array_item(buf);
+				ipc_json_write_node_recursive(buf, &child->node, NULL, NULL);
+			}
+		}
+		break;
+	}
+	ipc_json_write_array_end(buf);
+}
+
+void ipc_json_write_node_recursive(struct ipc_json_buffer *buf,
+		struct sway_node *node, const char *extra_key, json_object *extra_value) {
+	struct focus_map *map = NULL;
+	if (!focus_map && ipc_json_field_wanted("focus")) {
+		map = focus_map = focus_map_create(input_manager_get_default_seat());
+	}
+
+	// Only one node per level of the tree is described at a time, and its
+	// children are written in place of its "nodes"
+	json_object *object = ipc_json_describe_node(node);
+	bool has_nodes = false;
+	ipc_json_write_object_begin(buf);
+	json_object_object_foreach(object, key, value) {
+		ipc_json_write_key(buf, key);
+		if (strcmp(key, "nodes") == 0) {
+			write_node_children(buf, node);
+			has_nodes = true;
+		} else {
+			ipc_json_write(buf, value);
+		}
+	}
+	if (!has_nodes) {
+		ipc_json_write_key(buf, "nodes");
+		write_node_children(buf, node);
+	}
+	if (extra_key) {
+		ipc_json_write_key(buf, extra_key);
+		ipc_json_write(buf, extra_value);
+	}
+	ipc_json_write_object_end(buf);
+	json_object_put(object);
+
+	if (map) {
+		focus_map_destroy(map);
+		focus_map = NULL;
+	}
+}
+
 #if WLR_HAS_LIBINPUT_BACKEND
 static json_object *describe_libinput_device(struct libinput_device *device) {
 	json_object *object = json_object_new_object();
@@ -1253,6 +1627,100 @@ json_object *ipc_json_describe_seat(struct sway_seat *seat) {
 	return object;
 }
 
+json_object *ipc_json_describe_histogram(const struct sway_histogram *histogram) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "count",
+		json_object_new_int64(histogram->count));
+	json_object_object_add(object, "total_usec",
+		json_object_new_int64(histogram->total_usec));
+	json_object_object_add(object, "max_usec",
+		json_object_new_int64(histogram->max_usec));
+
+	json_object *buckets = json_object_new_array();
+	for (size_t i = 0; i < SWAY_HISTOGRAM_BUCKETS; i++) {
+		json_object *bucket = json_object_new_object();
+		json_object_object_add(bucket, "le_usec",
+			i < SWAY_HISTOGRAM_BUCKETS - 1 ?
+			json_object_new_int64(sway_histogram_bounds_usec[i]) : NULL);
+		json_object_object_add(bucket, "count",
+			json_object_new_int64(histogram->buckets[i]));
+		json_object_array_add(buckets, bucket);
+	}
+	json_object_object_add(object, "buckets", buckets);
+	return object;
+}
+
+json_object *ipc_json_describe_server_stats(void) {
+	json_object *object = json_object_new_object();
+
+	json_object_object_add(object, "commands",
+		ipc_json_describe_histogram(&server.timings.commands));
+
+	json_object *transactions = json_object_new_object();
+	json_object_object_add(transactions, "commit",
+		ipc_json_describe_histogram(&server.timings.transaction_commit));
+	json_object_object_add(transactions, "apply",
+		ipc_json_describe_histogram(&server.timings.transaction_apply));
+	json_object_object_add(transactions, "instructions_allocated",
+		json_object_new_int64(server.txn_pool_stats.instructions_allocated));
+	json_object_object_add(transactions, "instructions_reused",
+		json_object_new_int64(server.txn_pool_stats.instructions_reused));
+	json_object_object_add(transactions, "lists_allocated",
+		json_object_new_int64(server.txn_pool_stats.lists_allocated));
+	json_object_object_add(transactions, "lists_reused",
+		json_object_new_int64(server.txn_pool_stats.lists_reused));
+	json_object_object_add(transactions, "containers_arranged",
+		json_object_new_int64(server.arrange_stats.containers_arranged));
+	json_object_object_add(transactions, "containers_dirtied",
+		json_object_new_int64(server.arrange_stats.containers_dirtied));
+	json_object_object_add(object, "transactions", transactions);
+
+	json_object_object_add(object, "title_updates_coalesced",
+		json_object_new_int64(server.title_updates_coalesced));
+	json_object_object_add(object, "text_renders_coalesced",
+		json_object_new_int64(server.text_renders_coalesced));
+
+	json_object *text_cache = json_object_new_object();
+	json_object_object_add(text_cache, "hits",
+		json_object_new_int64(server.text_cache_stats.hits));
+	json_object_object_add(text_cache, "misses",
+		json_object_new_int64(server.text_cache_stats.misses));
+	json_object_object_add(text_cache, "evictions",
+		json_object_new_int64(server.text_cache_stats.evictions));
+	json_object_object_add(text_cache, "entries",
+		json_object_new_int64(server.text_cache_stats.entries));
+	json_object_object_add(text_cache, "bytes",
+		json_object_new_int64(server.text_cache_stats.bytes));
+	json_object_object_add(object, "text_cache", text_cache);
+
+	json_object *outputs = json_object_new_object();
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		json_object *output_stats = json_object_new_object();
+		json_object_object_add(output_stats, "scene_nodes_visited",
+			json_object_new_int64(output->configure_stats.nodes_visited));
+		json_object_object_add(output_stats, "scene_subtrees_skipped",
+			json_object_new_int64(output->configure_stats.subtrees_skipped));
+		json_object_object_add(outputs, output->wlr_output->name, output_stats);
+	}
+	json_object_object_add(object, "outputs", outputs);
+
+	json_object *seats = json_object_new_object();
+	struct sway_seat *seat;
+	wl_list_for_each(seat, &server.input->seats, link) {
+		struct sway_cursor *cursor = seat->cursor;
+		json_object *seat_stats = json_object_new_object();
+		json_object_object_add(seat_stats, "motion_batches",
+			json_object_new_int64(cursor->motion_batch.batches));
+		json_object_object_add(seat_stats, "motion_coalesced",
+			json_object_new_int64(cursor->motion_batch.coalesced));
+		json_object_object_add(seats, seat->wlr_seat->name, seat_stats);
+	}
+	json_object_object_add(object, "seats", seats);
+
+	return object;
+}
+
 static uint32_t event_to_x11_button(uint32_t event) {
 	switch (event) {
 	case BTN_LEFT:
@@ -2,23 +2,28 @@
 #include <linux/input-event-codes.h>
 #include <assert.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <fcntl.h>
 #include <json.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 #include <wayland-server-core.h>
 #include "sway/commands.h"
 #include "sway/config.h"
+#include "sway/criteria.h"
 #include "sway/desktop/transaction.h"
 #include "sway/ipc-json.h"
 #include "sway/ipc-server.h"
+#include "sway/ipc-tree.h"
 #include "sway/output.h"
 #include "sway/server.h"
 #include "sway/input/input-manager.h"
@@ -36,20 +41,104 @@ static struct wl_event_source *ipc_event_source =  NULL;
 static struct sockaddr_un *ipc_sockaddr = NULL;
 static list_t *ipc_client_list = NULL;
 static struct wl_listener ipc_display_destroy;
+static struct wl_event_source *ipc_tree_idle = NULL;
 
 static const char ipc_magic[] = {'i', '3', '-', 'i', 'p', 'c'};
 
 #define IPC_HEADER_SIZE (sizeof(ipc_magic) + 8)
 
+// Maximum number of messages handed to a single writev call
+#define IPC_WRITE_MAX_IOV 64
+
+// Message types 0-12 and 100-102, see ipc_stats_message_index
+#define IPC_STATS_MESSAGE_TYPES (IPC_GET_BINDING_STATE + 1 + \
+	IPC_GET_STATS - IPC_GET_INPUTS + 1)
+#define IPC_STATS_EVENT_TYPES 32
+
+struct ipc_event_stats {
+	uint64_t sent;
+	uint64_t deliveries; // one per subscriber
+	uint64_t bytes; // queued for all subscribers
+	struct sway_histogram fanout;
+};
+
+// Counters and timings reported by get_stats
+static struct {
+	struct sway_histogram messages[IPC_STATS_MESSAGE_TYPES];
+	struct ipc_event_stats events[IPC_STATS_EVENT_TYPES]; // by event_mask bit
+	struct sway_histogram get_tree;
+	uint64_t bytes_queued;
+	uint64_t bytes_written;
+	uint64_t backlog_disconnects;
+} ipc_stats;
+
+static const struct {
+	const char *name;
+	enum ipc_command_type type;
+} ipc_events[] = {
+	{ "workspace", IPC_EVENT_WORKSPACE },
+	{ "output", IPC_EVENT_OUTPUT },
+	{ "mode", IPC_EVENT_MODE },
+	{ "window", IPC_EVENT_WINDOW },
+	{ "barconfig_update", IPC_EVENT_BARCONFIG_UPDATE },
+	{ "binding", IPC_EVENT_BINDING },
+	{ "shutdown", IPC_EVENT_SHUTDOWN },
+	{ "tick", IPC_EVENT_TICK },
+	{ "bar_state_update", IPC_EVENT_BAR_STATE_UPDATE },
+	{ "input", IPC_EVENT_INPUT },
+	{ "tree", IPC_EVENT_TREE },
+};
+
+static const char *ipc_message_names[IPC_STATS_MESSAGE_TYPES] = {
+	"command", "get_workspaces", "subscribe", "get_outputs", "get_tree",
+	"get_marks", "get_bar_config", "get_version", "get_binding_modes",
+	"get_config", "send_tick", "sync", "get_binding_state",
+	"get_inputs", "get_seats", "get_stats",
+};
+
+static int ipc_stats_message_index(enum ipc_command_type type) {
+	if (type <= IPC_GET_BINDING_STATE) {
+		return type;
+	}
+	if (type >= IPC_GET_INPUTS && type <= IPC_GET_STATS) {
+		return IPC_GET_BINDING_STATE + 1 + type - IPC_GET_INPUTS;
+	}
+	return -1;
+}
+
+/**
+ * A serialized message. The header and the payload are written with separate
+ * iovecs, so the payload is never copied behind a header: it either lives in
+ * data, or is the serialized string of a JSON object the message keeps alive.
+ * Events are serialized once and the same message is queued for every
+ * subscriber.
+ */
+struct ipc_message {
+	int refs;
+	size_t length; // header and payload
+	char header[IPC_HEADER_SIZE];
+	const char *payload;
+	json_object *json; // owner of the payload, if not data
+	char data[];
+};
+
 struct ipc_client {
 	struct wl_event_source *event_source;
 	struct wl_event_source *writable_event_source;
 	struct sway_server *server;
 	int fd;
 	enum ipc_command_type subscribed_events;
-	size_t write_buffer_len;
-	size_t write_buffer_size;
-	char *write_buffer;
+	// Ring of messages waiting to be written to the client
+	struct ipc_message **write_queue;
+	size_t write_queue_head;
+	size_t write_queue_count;
+	size_t write_queue_capacity;
+	size_t write_offset; // bytes of the first message already written
+	size_t write_queued_bytes; // bytes not yet written
+	// Reported by get_stats
+	uint64_t messages_handled;
+	uint64_t handle_usec;
+	uint64_t bytes_written;
 	// The following are for storing data between event_loop calls
 	uint32_t pending_length;
 	enum ipc_command_type pending_type;
@@ -63,6 +152,149 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 	enum ipc_command_type payload_type);
 bool ipc_send_reply(struct ipc_client *client, enum ipc_command_type payload_type,
 	const char *payload, uint32_t payload_length);
+static bool ipc_send_reply_buffer(struct ipc_client *client,
+	enum ipc_command_type payload_type, struct ipc_json_buffer *buf);
+static bool ipc_send_reply_json(struct ipc_client *client,
+	enum ipc_command_type payload_type, json_object *object);
+
+static void ipc_message_init(struct ipc_message *message,
+		enum ipc_command_type payload_type, const char *payload,
+		uint32_t payload_length) {
+	message->refs = 1;
+	message->length = IPC_HEADER_SIZE + payload_length;
+	message->payload = payload;
+	message->json = NULL;
+
+	char *header = message->header;
+	memcpy(header, ipc_magic, sizeof(ipc_magic));
+	memcpy(header + sizeof(ipc_magic), &payload_length, sizeof(payload_length));
+	memcpy(header + sizeof(ipc_magic) + sizeof(payload_length), &payload_type, sizeof(payload_type));
+}
+
+static struct ipc_message *ipc_message_create(enum ipc_command_type payload_type,
+		const char *payload, uint32_t payload_length) {
+	struct ipc_message *message = malloc(sizeof(*message) + payload_length);
+	if (!message) {
+		return NULL;
+	}
+	memcpy(message->data, payload, payload_length);
+	ipc_message_init(message, payload_type, message->data, payload_length);
+	return message;
+}
+
+/**
+ * Create a message which sends the serialized JSON object as its payload.
+ * Takes ownership of the object, which is kept until the message is freed.
+ */
+static struct ipc_message *ipc_message_create_json(
+		enum ipc_command_type payload_type, json_object *json) {
+	struct ipc_message *message = malloc(sizeof(*message));
+	if (!message) {
+		json_object_put(json);
+		return NULL;
+	}
+	size_t payload_length;
+	const char *payload = json_object_to_json_string_length(json,
+		JSON_C_TO_STRING_SPACED, &payload_length);
+	ipc_message_init(message, payload_type, payload, (uint32_t)payload_length);
+	message->json = json;
+	return message;
+}
+
+/**
+ * Prepare a buffer for a JSON payload written with the ipc_json_write_*
+ * functions. Room for the message is left in front of the payload, so the
+ * buffer turns into the message without copying.
+ */
+static void ipc_message_buffer_init(struct ipc_json_buffer *buf) {
+	*buf = (struct ipc_json_buffer){
+		.length = offsetof(struct ipc_message, data),
+	};
+}
+
+static struct ipc_message *ipc_message_from_buffer(
+		enum ipc_command_type payload_type, struct ipc_json_buffer *buf) {
+	if (buf->failed || !buf->data) {
+		free(buf->data);
+		return NULL;
+	}
+	struct ipc_message *message = (struct ipc_message *)buf->data;
+	size_t payload_length = buf->length - offsetof(struct ipc_message, data);
+	ipc_message_init(message, payload_type, message->data,
+		(uint32_t)payload_length);
+	return message;
+}
+
+static void ipc_message_unref(struct ipc_message *message) {
+	if (--message->refs == 0) {
+		json_object_put(message->json);
+		free(message);
+	}
+}
+
+static struct ipc_message *ipc_client_queue_front(struct ipc_client *client) {
+	return client->write_queue[client->write_queue_head];
+}
+
+static void ipc_client_queue_pop(struct ipc_client *client) {
+	ipc_message_unref(ipc_client_queue_front(client));
+	client->write_queue_head =
+		(client->write_queue_head + 1) % client->write_queue_capacity;
+	client->write_queue_count--;
+	client->write_offset = 0;
+}
+
+/**
+ * Queues a message for the client and takes a reference to it. The client is
+ * disconnected if its queue grows too big or can't be allocated.
+ */
+static bool ipc_client_queue_message(struct ipc_client *client,
+		struct ipc_message *message) {
+	if (config->ipc_client_backlog &&
+			client->write_queued_bytes + message->length > config->ipc_client_backlog) {
+		sway_log(SWAY_ERROR, "Client write queue too big (%zu), disconnecting client",
+				client->write_queued_bytes + message->length);
+		ipc_stats.backlog_disconnects++;
+		ipc_client_disconnect(client);
+		return false;
+	}
+
+	if (client->write_queue_count == client->write_queue_capacity) {
+		size_t capacity = client->write_queue_capacity ?
+			client->write_queue_capacity * 2 : 8;
+		struct ipc_message **queue = malloc(capacity * sizeof(*queue));
+		if (!queue) {
+			sway_log(SWAY_ERROR, "Unable to reallocate ipc client write queue");
+			ipc_client_disconnect(client);
+			return false;
+		}
+		// Unwrap the ring into the new allocation
+		for (size_t i = 0; i < client->write_queue_count; i++) {
+			queue[i] = client->write_queue[
+				(client->write_queue_head + i) % client->write_queue_capacity];
+		}
+		free(client->write_queue);
+		client->write_queue = queue;
+		client->write_queue_head = 0;
+		client->write_queue_capacity = capacity;
+	}
+
+	size_t tail = (client->write_queue_head + client->write_queue_count)
+		% client->write_queue_capacity;
+	client->write_queue[tail] = message;
+	client->write_queue_count++;
+	client->write_queued_bytes += message->length;
+	message->refs++;
+	ipc_stats.bytes_queued += message->length;
+
+	if (!client->writable_event_source) {
+		client->writable_event_source = wl_event_loop_add_fd(
+				server.wl_event_loop, client->fd, WL_EVENT_WRITABLE,
+				ipc_client_handle_writable, client);
+	}
+
+	return true;
+}
 
 static void handle_display_destroy(struct wl_listener *listener, void *data) {
 	if (ipc_event_source) {
@@ -184,14 +416,15 @@ int ipc_handle_connection(int fd, uint32_t mask, void *data) {
 			client_fd, WL_EVENT_READABLE, ipc_client_handle_readable, client);
 	client->writable_event_source = NULL;
 
-	client->write_buffer_size = 128;
-	client->write_buffer_len = 0;
-	client->write_buffer = malloc(client->write_buffer_size);
-	if (!client->write_buffer) {
-		sway_log(SWAY_ERROR, "Unable to allocate ipc client write buffer");
-		close(client_fd);
-		return 0;
-	}
+	client->write_queue = NULL;
+	client->write_queue_head = 0;
+	client->write_queue_count = 0;
+	client->write_queue_capacity = 0;
+	client->write_offset = 0;
+	client->write_queued_bytes = 0;
+	client->messages_handled = 0;
+	client->handle_usec = 0;
+	client->bytes_written = 0;
 
 	sway_log(SWAY_DEBUG, "New client: fd %d", client_fd);
 	list_add(ipc_client_list, client);
@@ -264,6 +497,76 @@ int ipc_client_handle_readable(int client_fd, uint32_t mask, void *data) {
 	return 0;
 }
 
+static json_object *ipc_describe_stats(void) {
+	json_object *object = json_object_new_object();
+
+	json_object *clients = json_object_new_array();
+	for (int i = 0; i < ipc_client_list->length; i++) {
+		struct ipc_client *client = ipc_client_list->items[i];
+		json_object *client_json = json_object_new_object();
+		json_object_object_add(client_json, "fd",
+			json_object_new_int(client->fd));
+		json_object *subscriptions = json_object_new_array();
+		for (size_t j = 0; j < sizeof(ipc_events) / sizeof(ipc_events[0]); j++) {
+			if (client->subscribed_events & event_mask(ipc_events[j].type)) {
+				json_object_array_add(subscriptions,
+					json_object_new_string(ipc_events[j].name));
+			}
+		}
+		json_object_object_add(client_json, "subscriptions", subscriptions);
+		json_object_object_add(client_json, "messages_handled",
+			json_object_new_int64(client->messages_handled));
+		json_object_object_add(client_json, "handle_usec",
+			json_object_new_int64(client->handle_usec));
+		json_object_object_add(client_json, "bytes_written",
+			json_object_new_int64(client->bytes_written));
+		json_object_object_add(client_json, "queued_bytes",
+			json_object_new_int64(client->write_queued_bytes));
+		json_object_object_add(client_json, "queued_messages",
+			json_object_new_int64(client->write_queue_count));
+		json_object_array_add(clients, client_json);
+	}
+	json_object_object_add(object, "clients", clients);
+	json_object_object_add(object, "client_backlog",
+		json_object_new_int64(config->ipc_client_backlog));
+
+	json_object *messages = json_object_new_object();
+	for (int i = 0; i < IPC_STATS_MESSAGE_TYPES; i++) {
+		if (ipc_stats.messages[i].count) {
+			json_object_object_add(messages, ipc_message_names[i],
+				ipc_json_describe_histogram(&ipc_stats.messages[i]));
+		}
+	}
+	json_object_object_add(object, "messages", messages);
+
+	json_object *events = json_object_new_object();
+	for (size_t i = 0; i < sizeof(ipc_events) / sizeof(ipc_events[0]); i++) {
+		struct ipc_event_stats *stats =
+			&ipc_stats.events[ipc_events[i].type & 0x1F];
+		json_object *event = json_object_new_object();
+		json_object_object_add(event, "sent",
+			json_object_new_int64(stats->sent));
+		json_object_object_add(event, "deliveries",
+			json_object_new_int64(stats->deliveries));
+		json_object_object_add(event, "bytes",
+			json_object_new_int64(stats->bytes));
+		json_object_object_add(event, "fanout",
+			ipc_json_describe_histogram(&stats->fanout));
+		json_object_object_add(events, ipc_events[i].name, event);
+	}
+	json_object_object_add(object, "events", events);
+
+	json_object_object_add(object, "get_tree_serialization",
+		ipc_json_describe_histogram(&ipc_stats.get_tree));
+	json_object_object_add(object, "bytes_queued",
+		json_object_new_int64(ipc_stats.bytes_queued));
+	json_object_object_add(object, "bytes_written",
+		json_object_new_int64(ipc_stats.bytes_written));
+	json_object_object_add(object, "backlog_disconnects",
+		json_object_new_int64(ipc_stats.backlog_disconnects));
+	return object;
+}
+
 static bool ipc_has_event_listeners(enum ipc_command_type event) {
 	for (int i = 0; i < ipc_client_list->length; i++) {
 		struct ipc_client *client = ipc_client_list->items[i];
@@ -274,64 +577,130 @@ static bool ipc_has_event_listeners(enum ipc_command_type event) {
 	return false;
 }
 
-static void ipc_send_event(const char *json_string, enum ipc_command_type event) {
+static void ipc_send_event_message(struct ipc_message *message,
+		enum ipc_command_type event) {
+	if (!message) {
+		sway_log(SWAY_ERROR, "Unable to allocate ipc event");
+		return;
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	struct ipc_event_stats *stats = &ipc_stats.events[event & 0x1F];
+	stats->sent++;
+
 	struct ipc_client *client;
 	for (int i = 0; i < ipc_client_list->length; i++) {
 		client = ipc_client_list->items[i];
 		if ((client->subscribed_events & event_mask(event)) == 0) {
 			continue;
 		}
-		if (!ipc_send_reply(client, event, json_string,
-				(uint32_t)strlen(json_string))) {
+		stats->deliveries++;
+		stats->bytes += message->length;
+		if (!ipc_client_queue_message(client, message)) {
 			sway_log_errno(SWAY_INFO, "Unable to send reply to IPC client");
-			/* ipc_send_reply destroys client on error, which also
-			 * removes it from the list, so we need to process
+			/* ipc_client_queue_message destroys client on error, which
+			 * also removes it from the list, so we need to process
 			 * current index again */
 			i--;
 		}
 	}
+
+	ipc_message_unref(message);
+	histogram_add_since(&stats->fanout, &start);
+}
+
+/**
+ * Send an event with the JSON object as payload. Takes ownership of the object.
+ */
+static void ipc_send_event_json(json_object *json, enum ipc_command_type event) {
+	ipc_send_event_message(ipc_message_create_json(event, json), event);
+}
+
+void ipc_event_tree_flush(void) {
+	if (ipc_tree_idle) {
+		wl_event_source_remove(ipc_tree_idle);
+		ipc_tree_idle = NULL;
+	}
+	if (!ipc_has_event_listeners(IPC_EVENT_TREE)) {
+		ipc_tree_reset();
+		return;
+	}
+	json_object *obj = ipc_tree_diff();
+	if (!obj) {
+		return;
+	}
+	sway_log(SWAY_DEBUG, "Sending tree event %" PRIu64, ipc_tree_sequence());
+	ipc_send_event_json(obj, IPC_EVENT_TREE);
+}
+
+static void handle_tree_idle(void *data) {
+	ipc_tree_idle = NULL;
+	ipc_event_tree_flush();
+}
+
+void ipc_event_tree_schedule(void) {
+	if (ipc_tree_idle || !ipc_has_event_listeners(IPC_EVENT_TREE)) {
+		return;
+	}
+	// Coalesce all changes made while handling the current events
+	ipc_tree_idle = wl_event_loop_add_idle(server.wl_event_loop,
+		handle_tree_idle, NULL);
 }
 
 void ipc_event_workspace(struct sway_workspace *old,
 		struct sway_workspace *new, const char *change) {
+	ipc_event_tree_schedule();
 	if (!ipc_has_event_listeners(IPC_EVENT_WORKSPACE)) {
 		return;
 	}
 	sway_log(SWAY_DEBUG, "Sending workspace::%s event", change);
-	json_object *obj = json_object_new_object();
-	json_object_object_add(obj, "change", json_object_new_string(change));
+	struct ipc_json_buffer buf;
+	ipc_message_buffer_init(&buf);
+	ipc_json_write_object_begin(&buf);
+	ipc_json_write_key(&buf, "change");
+	json_object *change_str = json_object_new_string(change);
+	ipc_json_write(&buf, change_str);
+	json_object_put(change_str);
+
+	ipc_json_write_key(&buf, "old");
 	if (old) {
-		json_object_object_add(obj, "old",
-				ipc_json_describe_node_recursive(&old->node));
+		ipc_json_write_node_recursive(&buf, &old->node, NULL, NULL);
 	} else {
-		json_object_object_add(obj, "old", NULL);
+		ipc_json_write(&buf, NULL);
 	}
 
+	ipc_json_write_key(&buf, "current");
 	if (new) {
-		json_object_object_add(obj, "current",
-				ipc_json_describe_node_recursive(&new->node));
+		ipc_json_write_node_recursive(&buf, &new->node, NULL, NULL);
 	} else {
-		json_object_object_add(obj, "current", NULL);
+		ipc_json_write(&buf, NULL);
 	}
+	ipc_json_write_object_end(&buf);
 
-	const char *json_string = json_object_to_json_string(obj);
-	ipc_send_event(json_string, IPC_EVENT_WORKSPACE);
-	json_object_put(obj);
+	ipc_send_event_message(
+		ipc_message_from_buffer(IPC_EVENT_WORKSPACE, &buf), IPC_EVENT_WORKSPACE);
 }
 
 void ipc_event_window(struct sway_container *window, const char *change) {
+	ipc_event_tree_schedule();
 	if (!ipc_has_event_listeners(IPC_EVENT_WINDOW)) {
 		return;
 	}
 	sway_log(SWAY_DEBUG, "Sending window::%s event", change);
-	json_object *obj = json_object_new_object();
-	json_object_object_add(obj, "change", json_object_new_string(change));
-	json_object_object_add(obj, "container",
-			ipc_json_describe_node_recursive(&window->node));
-
-	const char *json_string = json_object_to_json_string(obj);
-	ipc_send_event(json_string, IPC_EVENT_WINDOW);
-	json_object_put(obj);
+	struct ipc_json_buffer buf;
+	ipc_message_buffer_init(&buf);
+	ipc_json_write_object_begin(&buf);
+	ipc_json_write_key(&buf, "change");
+	json_object *change_str = json_object_new_string(change);
+	ipc_json_write(&buf, change_str);
+	json_object_put(change_str);
+	ipc_json_write_key(&buf, "container");
+	ipc_json_write_node_recursive(&buf, &window->node, NULL, NULL);
+	ipc_json_write_object_end(&buf);
+
+	ipc_send_event_message(
+		ipc_message_from_buffer(IPC_EVENT_WINDOW, &buf), IPC_EVENT_WINDOW);
 }
 
 void ipc_event_barconfig_update(struct bar_config *bar) {
@@ -341,9 +710,7 @@ void ipc_event_barconfig_update(struct bar_config *bar) {
 	sway_log(SWAY_DEBUG, "Sending barconfig_update event");
 	json_object *json = ipc_json_describe_bar_config(bar);
 
-	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_BARCONFIG_UPDATE);
-	json_object_put(json);
+	ipc_send_event_json(json, IPC_EVENT_BARCONFIG_UPDATE);
 }
 
 void ipc_event_bar_state_update(struct bar_config *bar) {
@@ -357,9 +724,7 @@ void ipc_event_bar_state_update(struct bar_config *bar) {
 	json_object_object_add(json, "visible_by_modifier",
 			json_object_new_boolean(bar->visible_by_modifier));
 
-	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_BAR_STATE_UPDATE);
-	json_object_put(json);
+	ipc_send_event_json(json, IPC_EVENT_BAR_STATE_UPDATE);
 }
 
 void ipc_event_mode(const char *mode, bool pango) {
@@ -372,9 +737,7 @@ void ipc_event_mode(const char *mode, bool pango) {
 	json_object_object_add(obj, "pango_markup",
 			json_object_new_boolean(pango));
 
-	const char *json_string = json_object_to_json_string(obj);
-	ipc_send_event(json_string, IPC_EVENT_MODE);
-	json_object_put(obj);
+	ipc_send_event_json(obj, IPC_EVENT_MODE);
 }
 
 void ipc_event_shutdown(const char *reason) {
@@ -386,9 +749,7 @@ void ipc_event_shutdown(const char *reason) {
 	json_object *json = json_object_new_object();
 	json_object_object_add(json, "change", json_object_new_string(reason));
 
-	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_SHUTDOWN);
-	json_object_put(json);
+	ipc_send_event_json(json, IPC_EVENT_SHUTDOWN);
 }
 
 void ipc_event_binding(struct sway_binding *binding) {
@@ -472,9 +833,7 @@ void ipc_event_binding(struct sway_binding *binding) {
 	json_object *json = json_object_new_object();
 	json_object_object_add(json, "change", json_object_new_string("run"));
 	json_object_object_add(json, "binding", json_binding);
-	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_BINDING);
-	json_object_put(json);
+	ipc_send_event_json(json, IPC_EVENT_BINDING);
 }
 
 static void ipc_event_tick(const char *payload) {
@@ -487,9 +846,7 @@ static void ipc_event_tick(const char *payload) {
 	json_object_object_add(json, "first", json_object_new_boolean(false));
 	json_object_object_add(json, "payload", json_object_new_string(payload));
 
-	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_TICK);
-	json_object_put(json);
+	ipc_send_event_json(json, IPC_EVENT_TICK);
 }
 
 void ipc_event_input(const char *change, struct sway_input_device *device) {
@@ -502,12 +859,11 @@ void ipc_event_input(const char *change, struct sway_input_device *device) {
 	json_object_object_add(json, "change", json_object_new_string(change));
 	json_object_object_add(json, "input", ipc_json_describe_input(device));
 
-	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_INPUT);
-	json_object_put(json);
+	ipc_send_event_json(json, IPC_EVENT_INPUT);
 }
 
 void ipc_event_output(void) {
+	ipc_event_tree_schedule();
 	if (!ipc_has_event_listeners(IPC_EVENT_OUTPUT)) {
 		return;
 	}
@@ -516,9 +872,7 @@ void ipc_event_output(void) {
 	json_object *json = json_object_new_object();
 	json_object_object_add(json, "change", json_object_new_string("unspecified"));
 
-	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_OUTPUT);
-	json_object_put(json);
+	ipc_send_event_json(json, IPC_EVENT_OUTPUT);
 }
 
 int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
@@ -535,11 +889,32 @@ int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
 		return 0;
 	}
 
-	if (client->write_buffer_len <= 0) {
+	if (client->write_queue_count == 0) {
 		return 0;
 	}
 
-	ssize_t written = write(client->fd, client->write_buffer, client->write_buffer_len);
+	// Each message takes up to two iovecs, its header and its payload
+	struct iovec iov[IPC_WRITE_MAX_IOV * 2];
+	int iovcnt = 0;
+	size_t offset = client->write_offset;
+	for (size_t i = 0; i < client->write_queue_count && i < IPC_WRITE_MAX_IOV; i++) {
+		struct ipc_message *message = client->write_queue[
+			(client->write_queue_head + i) % client->write_queue_capacity];
+		if (offset < IPC_HEADER_SIZE) {
+			iov[iovcnt].iov_base = message->header + offset;
+			iov[iovcnt].iov_len = IPC_HEADER_SIZE - offset;
+			iovcnt++;
+			offset = IPC_HEADER_SIZE;
+		}
+		if (offset < message->length) {
+			iov[iovcnt].iov_base = (char *)message->payload + offset - IPC_HEADER_SIZE;
+			iov[iovcnt].iov_len = message->length - offset;
+			iovcnt++;
+		}
+		offset = 0;
+	}
+
+	ssize_t written = writev(client->fd, iov, iovcnt);
 
 	if (written == -1 && errno == EAGAIN) {
 		return 0;
@@ -549,10 +924,21 @@ int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
 		return 0;
 	}
 
-	memmove(client->write_buffer, client->write_buffer + written, client->write_buffer_len - written);
-	client->write_buffer_len -= written;
+	client->write_queued_bytes -= written;
+	client->bytes_written += written;
+	ipc_stats.bytes_written += written;
+	while (written > 0) {
+		struct ipc_message *message = ipc_client_queue_front(client);
+		size_t remaining = message->length - client->write_offset;
+		if ((size_t)written < remaining) {
+			client->write_offset += written;
+			break;
+		}
+		written -= remaining;
+		ipc_client_queue_pop(client);
+	}
 
-	if (client->write_buffer_len == 0 && client->writable_event_source) {
+	if (client->write_queue_count == 0 && client->writable_event_source) {
 		wl_event_source_remove(client->writable_event_source);
 		client->writable_event_source = NULL;
 	}
@@ -577,36 +963,156 @@ void ipc_client_disconnect(struct ipc_client *client) {
 		i++;
 	}
 	list_del(ipc_client_list, i);
-	free(client->write_buffer);
+	if ((client->subscribed_events & event_mask(IPC_EVENT_TREE)) &&
+			!ipc_has_event_listeners(IPC_EVENT_TREE)) {
+		ipc_event_tree_flush();
+	}
+	while (client->write_queue_count > 0) {
+		ipc_client_queue_pop(client);
+	}
+	free(client->write_queue);
 	close(client->fd);
 	free(client);
 }
 
+/**
+ * Options of the get_* messages, given as an optional JSON object payload.
+ */
+struct ipc_query {
+	struct ipc_json_fields *fields; // NULL to include all fields
+	bool has_id;
+	size_t id;
+	struct criteria *criteria; // get_tree only
+	bool sequence; // get_tree only
+};
+
+static void ipc_query_finish(struct ipc_query *query) {
+	ipc_json_fields_destroy(query->fields);
+	if (query->criteria) {
+		criteria_destroy(query->criteria);
+	}
+}
+
+/**
+ * Parse the payload of a get_* message. Payloads that aren't JSON objects are
+ * ignored for compatibility. Returns an error message on failure.
+ */
+static char *ipc_query_parse(const char *buf, struct ipc_query *query) {
+	*query = (struct ipc_query){0};
+	json_object *request = buf[0] ? json_tokener_parse(buf) : NULL;
+	if (!request || !json_object_is_type(request, json_type_object)) {
+		json_object_put(request);
+		return NULL;
+	}
+
+	char *error = NULL;
+	json_object *value;
+	if (json_object_object_get_ex(request, "fields", &value)) {
+		query->fields = ipc_json_fields_parse(value, &error);
+		if (!query->fields) {
+			goto out;
+		}
+	}
+	if (json_object_object_get_ex(request, "id", &value)) {
+		if (!json_object_is_type(value, json_type_int)) {
+			error = strdup("id must be an integer");
+			goto out;
+		}
+		query->has_id = true;
+		query->id = (size_t)json_object_get_int64(value);
+	}
+	if (json_object_object_get_ex(request, "criteria", &value)) {
+		if (!json_object_is_type(value, json_type_string)) {
+			error = strdup("criteria must be a string");
+			goto out;
+		}
+		char *raw = strdup(json_object_get_string(value));
+		query->criteria = criteria_parse(raw, &error);
+		free(raw);
+		if (!query->criteria) {
+			goto out;
+		}
+	}
+	if (json_object_object_get_ex(request, "sequence", &value)) {
+		query->sequence = json_object_get_boolean(value);
+	}
+
+out:
+	json_object_put(request);
+	if (error) {
+		ipc_query_finish(query);
+	}
+	return error;
+}
+
+static void ipc_send_error(struct ipc_client *client,
+		enum ipc_command_type payload_type, const char *error) {
+	json_object *reply = json_object_new_object();
+	json_object_object_add(reply, "success", json_object_new_boolean(false));
+	json_object_object_add(reply, "error", json_object_new_string(error));
+	const char *json_string = json_object_to_json_string(reply);
+	ipc_send_reply(client, payload_type, json_string,
+		(uint32_t)strlen(json_string));
+	json_object_put(reply);
+}
+
+static struct sway_node *ipc_find_node(size_t id) {
+	if (root->node.id == id) {
+		return &root->node;
+	}
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		if (output->node.id == id) {
+			return &output->node;
+		}
+		for (int j = 0; j < output->workspaces->length; ++j) {
+			struct sway_workspace *ws = output->workspaces->items[j];
+			if (ws->node.id == id) {
+				return &ws->node;
+			}
+		}
+	}
+	struct sway_container *con = root_find_container_by_id(id);
+	return con ? &con->node : NULL;
+}
+
+struct get_workspaces_data {
+	json_object *workspaces;
+	struct ipc_query *query;
+};
+
 static void ipc_get_workspaces_callback(struct sway_workspace *workspace,
-		void *data) {
+		void *_data) {
+	struct get_workspaces_data *data = _data;
+	if (data->query->has_id && workspace->node.id != data->query->id) {
+		return;
+	}
 	json_object *workspace_json = ipc_json_describe_node(&workspace->node);
+	json_object_array_add(data->workspaces, workspace_json);
+
 	// override the default focused indicator because
 	// it's set differently for the get_workspaces reply
-	struct sway_seat *seat = input_manager_get_default_seat();
-	struct sway_workspace *focused_ws = seat_get_focused_workspace(seat);
-	bool focused = workspace == focused_ws;
-	json_object_object_del(workspace_json, "focused");
-	json_object_object_add(workspace_json, "focused",
-			json_object_new_boolean(focused));
-	json_object_array_add((json_object *)data, workspace_json);
+	if (ipc_json_field_wanted("focused")) {
+		struct sway_seat *seat = input_manager_get_default_seat();
+		struct sway_workspace *focused_ws = seat_get_focused_workspace(seat);
+		bool focused = workspace == focused_ws;
+		json_object_object_del(workspace_json, "focused");
+		json_object_object_add(workspace_json, "focused",
+				json_object_new_boolean(focused));
+	}
 
-	focused_ws = output_get_active_workspace(workspace->output);
-	bool visible = workspace == focused_ws;
-	json_object_object_add(workspace_json, "visible",
-			json_object_new_boolean(visible));
+	if (ipc_json_field_wanted("visible")) {
+		struct sway_workspace *active_ws =
+			output_get_active_workspace(workspace->output);
+		bool visible = workspace == active_ws;
+		json_object_object_add(workspace_json, "visible",
+				json_object_new_boolean(visible));
+	}
 }
 
-static void ipc_get_marks_callback(struct sway_container *con, void *data) {
-	json_object *marks = (json_object *)data;
-	for (int i = 0; i < con->marks->length; ++i) {
-		char *mark = (char *)con->marks->items[i];
-		json_object_array_add(marks, json_object_new_string(mark));
-	}
+static void ipc_get_marks_callback(const char *mark,
+		struct sway_container *con, void *data) {
+	json_object_array_add(data, json_object_new_string(mark));
 }
 
 void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_length,
@@ -634,6 +1140,10 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 	}
 	buf[payload_length] = '\0';
 
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	client->messages_handled++;
+
 	switch (payload_type) {
 	case IPC_COMMAND:
 	{
@@ -677,37 +1187,63 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 
 	case IPC_GET_OUTPUTS:
 	{
+		struct ipc_query query;
+		char *error = ipc_query_parse(buf, &query);
+		if (error) {
+			ipc_send_error(client, payload_type, error);
+			free(error);
+			goto exit_cleanup;
+		}
+		ipc_json_set_fields(query.fields);
+
 		json_object *outputs = json_object_new_array();
 		for (int i = 0; i < root->outputs->length; ++i) {
 			struct sway_output *output = root->outputs->items[i];
+			if (query.has_id && output->node.id != query.id) {
+				continue;
+			}
 			json_object *output_json = ipc_json_describe_node(&output->node);
 
 			// override the default focused indicator because it's set
 			// differently for the get_outputs reply
-			struct sway_seat *seat = input_manager_get_default_seat();
-			struct sway_workspace *focused_ws =
-				seat_get_focused_workspace(seat);
-			bool focused = focused_ws && output == focused_ws->output;
-			json_object_object_del(output_json, "focused");
-			json_object_object_add(output_json, "focused",
-				json_object_new_boolean(focused));
+			if (ipc_json_field_wanted("focused")) {
+				struct sway_seat *seat = input_manager_get_default_seat();
+				struct sway_workspace *focused_ws =
+					seat_get_focused_workspace(seat);
+				bool focused = focused_ws && output == focused_ws->output;
+				json_object_object_del(output_json, "focused");
+				json_object_object_add(output_json, "focused",
+					json_object_new_boolean(focused));
+			}
 
-			const char *subpixel = sway_wl_output_subpixel_to_string(output->wlr_output->subpixel);
-			json_object_object_add(output_json, "subpixel_hinting", json_object_new_string(subpixel));
+			if (ipc_json_field_wanted("subpixel_hinting")) {
+				const char *subpixel = sway_wl_output_subpixel_to_string(output->wlr_output->subpixel);
+				json_object_object_add(output_json, "subpixel_hinting", json_object_new_string(subpixel));
+			}
 			json_object_array_add(outputs, output_json);
 		}
-		struct sway_output *output;
-		wl_list_for_each(output, &root->all_outputs, link) {
-			if (!output->enabled && output != root->fallback_output) {
-				json_object_array_add(outputs,
-						ipc_json_describe_disabled_output(output));
+		if (!query.has_id) {
+			// Disabled and non-desktop outputs have no node ID
+			struct sway_output *output;
+			wl_list_for_each(output, &root->all_outputs, link) {
+				if (!output->enabled && output != root->fallback_output) {
+					json_object *output_json =
+						ipc_json_describe_disabled_output(output);
+					ipc_json_project(output_json);
+					json_object_array_add(outputs, output_json);
+				}
 			}
-		}
 
-		for (int i = 0; i < root->non_desktop_outputs->length; i++) {
-			struct sway_output_non_desktop *non_desktop_output = root->non_desktop_outputs->items[i];
-			json_object_array_add(outputs, ipc_json_describe_non_desktop_output(non_desktop_output));
+			for (int i = 0; i < root->non_desktop_outputs->length; i++) {
+				struct sway_output_non_desktop *non_desktop_output = root->non_desktop_outputs->items[i];
+				json_object *output_json =
+					ipc_json_describe_non_desktop_output(non_desktop_output);
+				ipc_json_project(output_json);
+				json_object_array_add(outputs, output_json);
+			}
 		}
+		ipc_json_set_fields(NULL);
+		ipc_query_finish(&query);
 
 		const char *json_string = json_object_to_json_string(outputs);
 		ipc_send_reply(client, payload_type, json_string,
@@ -718,12 +1254,25 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 
 	case IPC_GET_WORKSPACES:
 	{
-		json_object *workspaces = json_object_new_array();
-		root_for_each_workspace(ipc_get_workspaces_callback, workspaces);
-		const char *json_string = json_object_to_json_string(workspaces);
-		ipc_send_reply(client, payload_type, json_string,
-			(uint32_t)strlen(json_string));
-		json_object_put(workspaces); // free
+		struct ipc_query query;
+		char *error = ipc_query_parse(buf, &query);
+		if (error) {
+			ipc_send_error(client, payload_type, error);
+			free(error);
+			goto exit_cleanup;
+		}
+		ipc_json_set_fields(query.fields);
+
+		struct get_workspaces_data data = {
+			.workspaces = json_object_new_array(),
+			.query = &query,
+		};
+		root_for_each_workspace(ipc_get_workspaces_callback, &data);
+		ipc_json_set_fields(NULL);
+		ipc_query_finish(&query);
+
+		ipc_send_reply_json(client, payload_type, data.workspaces);
+		json_object_put(data.workspaces); // free
 		goto exit_cleanup;
 	}
 
@@ -739,37 +1288,25 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 		}
 
 		bool is_tick = false;
+		bool is_tree = false;
 		// parse requested event types
 		for (size_t i = 0; i < json_object_array_length(request); i++) {
 			const char *event_type = json_object_get_string(json_object_array_get_idx(request, i));
-			if (strcmp(event_type, "workspace") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_WORKSPACE);
-			} else if (strcmp(event_type, "output") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_OUTPUT);
-			} else if (strcmp(event_type, "barconfig_update") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_BARCONFIG_UPDATE);
-			} else if (strcmp(event_type, "bar_state_update") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_BAR_STATE_UPDATE);
-			} else if (strcmp(event_type, "mode") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_MODE);
-			} else if (strcmp(event_type, "shutdown") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_SHUTDOWN);
-			} else if (strcmp(event_type, "window") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_WINDOW);
-			} else if (strcmp(event_type, "binding") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_BINDING);
-			} else if (strcmp(event_type, "tick") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_TICK);
-				is_tick = true;
-			} else if (strcmp(event_type, "input") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_INPUT);
-			} else {
+			size_t j = 0;
+			while (j < sizeof(ipc_events) / sizeof(ipc_events[0]) &&
+					strcmp(event_type, ipc_events[j].name) != 0) {
+				j++;
+			}
+			if (j == sizeof(ipc_events) / sizeof(ipc_events[0])) {
 				const char msg[] = "{\"success\": false}";
 				ipc_send_reply(client, payload_type, msg, strlen(msg));
 				json_object_put(request);
 				sway_log(SWAY_INFO, "Unsupported event type in subscribe request");
 				goto exit_cleanup;
 			}
+			client->subscribed_events |= event_mask(ipc_events[j].type);
+			is_tick |= ipc_events[j].type == IPC_EVENT_TICK;
+			is_tree |= ipc_events[j].type == IPC_EVENT_TREE;
 		}
 
 		json_object_put(request);
@@ -780,6 +1317,10 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 			ipc_send_reply(client, IPC_EVENT_TICK, tickmsg,
 				strlen(tickmsg));
 		}
+		if (is_tree) {
+			// Make sure there is a snapshot to diff the next changes against
+			ipc_event_tree_flush();
+		}
 		goto exit_cleanup;
 	}
 
@@ -811,20 +1352,80 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 		goto exit_cleanup;
 	}
 
+	case IPC_GET_STATS:
+	{
+		json_object *stats = ipc_json_describe_server_stats();
+		json_object_object_add(stats, "ipc", ipc_describe_stats());
+		ipc_send_reply_json(client, payload_type, stats);
+		json_object_put(stats);
+		goto exit_cleanup;
+	}
+
 	case IPC_GET_TREE:
 	{
-		json_object *tree = ipc_json_describe_node_recursive(&root->node);
-		const char *json_string = json_object_to_json_string(tree);
-		ipc_send_reply(client, payload_type, json_string,
-			(uint32_t)strlen(json_string));
-		json_object_put(tree);
+		struct ipc_query query;
+		char *error = ipc_query_parse(buf, &query);
+		if (error) {
+			ipc_send_error(client, payload_type, error);
+			free(error);
+			goto exit_cleanup;
+		}
+		struct sway_node *node = &root->node;
+		if (query.has_id && !(node = ipc_find_node(query.id))) {
+			ipc_send_error(client, payload_type, "No node with that ID");
+			ipc_query_finish(&query);
+			goto exit_cleanup;
+		}
+		if (query.sequence) {
+			// Send out pending changes first, so the snapshot matches the
+			// sequence number
+			ipc_event_tree_flush();
+		}
+
+		if (query.fields) {
+			// Always keep the structure of the tree
+			ipc_json_fields_add(query.fields, "nodes");
+			ipc_json_fields_add(query.fields, "floating_nodes");
+		}
+		ipc_json_set_fields(query.fields);
+		struct timespec serialize_start;
+		clock_gettime(CLOCK_MONOTONIC, &serialize_start);
+		struct ipc_json_buffer tree;
+		ipc_message_buffer_init(&tree);
+		if (query.criteria) {
+			// A flat list of the matching containers within the node
+			ipc_json_write_array_begin(&tree);
+			list_t *containers = criteria_get_containers(query.criteria);
+			for (int i = 0; i < containers->length; ++i) {
+				struct sway_container *con = containers->items[i];
+				if (!query.has_id || &con->node == node ||
+						node_has_ancestor(&con->node, node)) {
+					ipc_json_write_array_item(&tree);
+					ipc_json_write_node_recursive(&tree, &con->node,
+						NULL, NULL);
+				}
+			}
+			list_free(containers);
+			ipc_json_write_array_end(&tree);
+		} else {
+			json_object *sequence = query.sequence ?
+				json_object_new_int64((int64_t)ipc_tree_sequence()) : NULL;
+			ipc_json_write_node_recursive(&tree, node,
+				sequence ? "tree_sequence" : NULL, sequence);
+			json_object_put(sequence);
+		}
+		ipc_json_set_fields(NULL);
+		ipc_query_finish(&query);
+		histogram_add_since(&ipc_stats.get_tree, &serialize_start);
+
+		ipc_send_reply_buffer(client, payload_type, &tree);
 		goto exit_cleanup;
 	}
 
 	case IPC_GET_MARKS:
 	{
 		json_object *marks = json_object_new_array();
-		root_for_each_container(ipc_get_marks_callback, marks);
+		root_for_each_mark(ipc_get_marks_callback, marks);
 		const char *json_string = json_object_to_json_string(marks);
 		ipc_send_reply(client, payload_type, json_string,
 			(uint32_t)strlen(json_string));
@@ -930,48 +1531,49 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 
 exit_cleanup:
 	free(buf);
-}
 
-bool ipc_send_reply(struct ipc_client *client, enum ipc_command_type payload_type,
-		const char *payload, uint32_t payload_length) {
-	assert(payload);
-
-	char data[IPC_HEADER_SIZE];
-
-	memcpy(data, ipc_magic, sizeof(ipc_magic));
-	memcpy(data + sizeof(ipc_magic), &payload_length, sizeof(payload_length));
-	memcpy(data + sizeof(ipc_magic) + sizeof(payload_length), &payload_type, sizeof(payload_type));
-
-	while (client->write_buffer_len + IPC_HEADER_SIZE + payload_length >=
-				 client->write_buffer_size) {
-		client->write_buffer_size *= 2;
+	uint64_t usec = stats_elapsed_usec(&start);
+	int index = ipc_stats_message_index(payload_type);
+	if (index >= 0) {
+		histogram_add(&ipc_stats.messages[index], usec);
 	}
-
-	if (client->write_buffer_size > 4e6) { // 4 MB
-		sway_log(SWAY_ERROR, "Client write buffer too big (%zu), disconnecting client",
-				client->write_buffer_size);
-		ipc_client_disconnect(client);
-		return false;
+	// The client is gone if sending the reply failed
+	if (list_find(ipc_client_list, client) != -1) {
+		client->handle_usec += usec;
 	}
+}
 
-	char *new_buffer = realloc(client->write_buffer, client->write_buffer_size);
-	if (!new_buffer) {
-		sway_log(SWAY_ERROR, "Unable to reallocate ipc client write buffer");
+static bool ipc_send_reply_message(struct ipc_client *client,
+		struct ipc_message *message) {
+	if (!message) {
+		sway_log(SWAY_ERROR, "Unable to allocate ipc client reply");
 		ipc_client_disconnect(client);
 		return false;
 	}
-	client->write_buffer = new_buffer;
 
-	memcpy(client->write_buffer + client->write_buffer_len, data, IPC_HEADER_SIZE);
-	client->write_buffer_len += IPC_HEADER_SIZE;
-	memcpy(client->write_buffer + client->write_buffer_len, payload, payload_length);
-	client->write_buffer_len += payload_length;
+	bool queued = ipc_client_queue_message(client, message);
+	ipc_message_unref(message);
+	return queued;
+}
 
-	if (!client->writable_event_source) {
-		client->writable_event_source = wl_event_loop_add_fd(
-				server.wl_event_loop, client->fd, WL_EVENT_WRITABLE,
-				ipc_client_handle_writable, client);
-	}
+bool ipc_send_reply(struct ipc_client *client, enum ipc_command_type payload_type,
+		const char *payload, uint32_t payload_length) {
+	assert(payload);
 
-	return true;
+	return ipc_send_reply_message(client,
+		ipc_message_create(payload_type, payload, payload_length));
+}
+
+static bool ipc_send_reply_buffer(struct ipc_client *client,
+		enum ipc_command_type payload_type, struct ipc_json_buffer *buf) {
+	return ipc_send_reply_message(client,
+		ipc_message_from_buffer(payload_type, buf));
+}
+
+static bool ipc_send_reply_json(struct ipc_client *client,
+		enum ipc_command_type payload_type, json_object *object) {
+	struct ipc_json_buffer buf;
+	ipc_message_buffer_init(&buf);
+	ipc_json_write(&buf, object);
+	return ipc_send_reply_buffer(client, payload_type, &buf);
 }
@@ -0,0 +1,394 @@
+#include <json.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wlr/util/box.h>
+#include "sway/ipc-json.h"
+#include "sway/ipc-tree.h"
+#include "sway/input/input-manager.h"
+#include "sway/input/seat.h"
+#include "sway/output.h"
+#include "sway/tree/container.h"
+#include "sway/tree/node.h"
+#include "sway/tree/root.h"
+#include "sway/tree/view.h"
+#include "sway/tree/workspace.h"
+#include "list.h"
+#include "log.h"
+
+/**
+ * The state of a single node as seen by tree events. Everything is copied out
+ * of the tree so a snapshot stays valid after the node has been destroyed.
+ */
+struct tree_node_state {
+	int id;
+	int parent; // -1 for the root
+	int index;
+	bool floating;
+
+	const char *type;
+	char *name;
+	char *app_id;
+	const char *layout;
+	struct wlr_box rect;
+	bool focused;
+	bool urgent;
+	int fullscreen_mode;
+	list_t *marks; // char *
+
+	// Matching node of the previous snapshot, only set while diffing
+	struct tree_node_state *prev;
+};
+
+struct tree_snapshot {
+	struct tree_node_state *nodes; // in get_tree order
+	size_t length;
+	size_t capacity;
+	struct tree_node_state **by_id; // sorted by id
+};
+
+static struct tree_snapshot *snapshot = NULL;
+static uint64_t sequence = 0;
+
+static void node_state_finish(struct tree_node_state *state) {
+	free(state->name);
+	free(state->app_id);
+	list_free_items_and_destroy(state->marks);
+}
+
+static void snapshot_destroy(struct tree_snapshot *snap) {
+	if (!snap) {
+		return;
+	}
+	for (size_t i = 0; i < snap->length; ++i) {
+		node_state_finish(&snap->nodes[i]);
+	}
+	free(snap->nodes);
+	free(snap->by_id);
+	free(snap);
+}
+
+static void snapshot_add(struct tree_snapshot *snap, struct sway_node *node,
+		int parent, int index, bool floating, struct sway_node *focus) {
+	if (snap->length == snap->capacity) {
+		size_t capacity = snap->capacity ? snap->capacity * 2 : 64;
+		struct tree_node_state *nodes =
+			realloc(snap->nodes, capacity * sizeof(*nodes));
+		if (!nodes) {
+			sway_log(SWAY_ERROR, "Unable to allocate tree snapshot");
+			return;
+		}
+		snap->nodes = nodes;
+		snap->capacity = capacity;
+	}
+
+	struct tree_node_state *state = &snap->nodes[snap->length++];
+	*state = (struct tree_node_state){
+		.id = (int)node->id,
+		.parent = parent,
+		.index = index,
+		.floating = floating,
+		.type = ipc_json_node_type_description(node->type),
+		.layout = ipc_json_layout_description(node_get_layout(node)),
+		.focused = node == focus,
+		.marks = create_list(),
+	};
+	char *name = node_get_name(node);
+	state->name = name ? strdup(name) : NULL;
+	ipc_json_get_node_rect(node, &state->rect);
+
+	switch (node->type) {
+	case N_ROOT:
+	case N_OUTPUT:
+		break;
+	case N_WORKSPACE:
+		state->urgent = node->sway_workspace->urgent;
+		state->fullscreen_mode = 1;
+		break;
+	case N_CONTAINER:;
+		struct sway_container *con = node->sway_container;
+		if (floating) {
+			state->type = "floating_con";
+		}
+		state->urgent = con->view ?
+			view_is_urgent(con->view) : container_has_urgent_child(con);
+		state->fullscreen_mode = con->pending.fullscreen_mode;
+		const char *app_id = con->view ? view_get_app_id(con->view) : NULL;
+		state->app_id = app_id ? strdup(app_id) : NULL;
+		for (int i = 0; i < con->marks->length; ++i) {
+			list_add(state->marks, strdup(con->marks->items[i]));
+		}
+		break;
+	}
+}
+
+static void snapshot_add_containers(struct tree_snapshot *snap,
+		list_t *containers, int parent, bool floating,
+		struct sway_node *focus) {
+	for (int i = 0; i < containers->length; ++i) {
+		struct sway_container *con = containers->items[i];
+		snapshot_add(snap, &con->node, parent, i, floating, focus);
+		if (con->pending.children) {
+			snapshot_add_containers(snap, con->pending.children,
+				(int)con->node.id, false, focus);
+		}
+	}
+}
+
+static int compare_node_id(const void *_a, const void *_b) {
+	const struct tree_node_state *a = *(struct tree_node_state **)_a;
+	const struct tree_node_state *b = *(struct tree_node_state **)_b;
+	return (a->id > b->id) - (a->id < b->id);
+}
+
+static struct tree_snapshot *snapshot_create(void) {
+	struct tree_snapshot *snap = calloc(1, sizeof(*snap));
+	if (!snap) {
+		return NULL;
+	}
+	struct sway_seat *seat = input_manager_get_default_seat();
+	struct sway_node *focus = seat ? seat_get_focus(seat) : NULL;
+
+	snapshot_add(snap, &root->node, -1, 0, false, focus);
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		// Index 0 of the root is taken by the __i3 output
+		snapshot_add(snap, &output->node, (int)root->node.id, i + 1,
+			false, focus);
+		for (int j = 0; j < output->workspaces->length; ++j) {
+			struct sway_workspace *ws = output->workspaces->items[j];
+			snapshot_add(snap, &ws->node, (int)output->node.id, j,
+				false, focus);
+			snapshot_add_containers(snap, ws->tiling, (int)ws->node.id,
+				false, focus);
+			snapshot_add_containers(snap, ws->floating, (int)ws->node.id,
+				true, focus);
+		}
+	}
+
+	int scratch_index = 0;
+	for (int i = 0; i < root->scratchpad->length; ++i) {
+		struct sway_container *con = root->scratchpad->items[i];
+		if (!container_is_scratchpad_hidden(con)) {
+			continue;
+		}
+		snapshot_add(snap, &con->node, i3_scratch_id, scratch_index++,
+			true, focus);
+		if (con->pending.children) {
+			snapshot_add_containers(snap, con->pending.children,
+				(int)con->node.id, false, focus);
+		}
+	}
+
+	snap->by_id = malloc((snap->length ? snap->length : 1) * sizeof(*snap->by_id));
+	if (!snap->by_id) {
+		snapshot_destroy(snap);
+		return NULL;
+	}
+	for (size_t i = 0; i < snap->length; ++i) {
+		snap->by_id[i] = &snap->nodes[i];
+	}
+	qsort(snap->by_id, snap->length, sizeof(*snap->by_id), compare_node_id);
+	return snap;
+}
+
+static bool marks_equal(list_t *a, list_t *b) {
+	if (a->length != b->length) {
+		return false;
+	}
+	for (int i = 0; i < a->length; ++i) {
+		if (strcmp(a->items[i], b->items[i]) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool string_equal(const char *a, const char *b) {
+	return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+static json_object *json_string_or_null(const char *str) {
+	return str ? json_object_new_string(str) : NULL;
+}
+
+static json_object *describe_rect(struct wlr_box *box) {
+	json_object *rect = json_object_new_object();
+	json_object_object_add(rect, "x", json_object_new_int(box->x));
+	json_object_object_add(rect, "y", json_object_new_int(box->y));
+	json_object_object_add(rect, "width", json_object_new_int(box->width));
+	json_object_object_add(rect, "height", json_object_new_int(box->height));
+	return rect;
+}
+
+static json_object *describe_marks(list_t *marks) {
+	json_object *array = json_object_new_array();
+	for (int i = 0; i < marks->length; ++i) {
+		json_object_array_add(array, json_object_new_string(marks->items[i]));
+	}
+	return array;
+}
+
+static json_object *create_change(const char *change, int id) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "change", json_object_new_string(change));
+	json_object_object_add(object, "id", json_object_new_int(id));
+	return object;
+}
+
+static void describe_position(struct tree_node_state *state,
+		json_object *object) {
+	json_object_object_add(object, "parent",
+			state->parent >= 0 ? json_object_new_int(state->parent) : NULL);
+	json_object_object_add(object, "index", json_object_new_int(state->index));
+	json_object_object_add(object, "floating",
+			json_object_new_boolean(state->floating));
+}
+
+/**
+ * Add the properties of state that differ from prev to object, or all of them
+ * if prev is NULL. Returns the number of properties added.
+ */
+static int describe_properties(struct tree_node_state *state,
+		struct tree_node_state *prev, json_object *object) {
+	int count = 0;
+	if (!prev || strcmp(state->type, prev->type) != 0) {
+		json_object_object_add(object, "type",
+				json_object_new_string(state->type));
+		++count;
+	}
+	if (!prev || !string_equal(state->name, prev->name)) {
+		json_object_object_add(object, "name", json_string_or_null(state->name));
+		++count;
+	}
+	if (!prev || !string_equal(state->app_id, prev->app_id)) {
+		json_object_object_add(object, "app_id",
+				json_string_or_null(state->app_id));
+		++count;
+	}
+	if (!prev || strcmp(state->layout, prev->layout) != 0) {
+		json_object_object_add(object, "layout",
+				json_object_new_string(state->layout));
+		++count;
+	}
+	if (!prev || memcmp(&state->rect, &prev->rect, sizeof(state->rect)) != 0) {
+		json_object_object_add(object, "rect", describe_rect(&state->rect));
+		++count;
+	}
+	if (!prev || state->focused != prev->focused) {
+		json_object_object_add(object, "focused",
+				json_object_new_boolean(state->focused));
+		++count;
+	}
+	if (!prev || state->urgent != prev->urgent) {
+		json_object_object_add(object, "urgent",
+				json_object_new_boolean(state->urgent));
+		++count;
+	}
+	if (!prev || state->fullscreen_mode != prev->fullscreen_mode) {
+		json_object_object_add(object, "fullscreen_mode",
+				json_object_new_int(state->fullscreen_mode));
+		++count;
+	}
+	if (!prev || !marks_equal(state->marks, prev->marks)) {
+		json_object_object_add(object, "marks", describe_marks(state->marks));
+		++count;
+	}
+	return count;
+}
+
+static json_object *snapshot_diff(struct tree_snapshot *old,
+		struct tree_snapshot *new) {
+	json_object *changes = json_object_new_array();
+
+	// Match nodes by id. Nodes only present in the old snapshot were removed.
+	size_t i = 0, j = 0;
+	while (i < old->length || j < new->length) {
+		struct tree_node_state *a = i < old->length ? old->by_id[i] : NULL;
+		struct tree_node_state *b = j < new->length ? new->by_id[j] : NULL;
+		if (a && b && a->id == b->id) {
+			b->prev = a;
+			++i, ++j;
+		} else if (a && (!b || a->id < b->id)) {
+			json_object_array_add(changes, create_change("removed", a->id));
+			++i;
+		} else {
+			b->prev = NULL;
+			++j;
+		}
+	}
+
+	// Report everything else in tree order, so parents are added before
+	// their children
+	for (size_t k = 0; k < new->length; ++k) {
+		struct tree_node_state *state = &new->nodes[k];
+		struct tree_node_state *prev = state->prev;
+		if (!prev) {
+			json_object *object = create_change("added", state->id);
+			describe_position(state, object);
+			describe_properties(state, NULL, object);
+			json_object_array_add(changes, object);
+			continue;
+		}
+
+		if (state->parent != prev->parent || state->index != prev->index
+				|| state->floating != prev->floating) {
+			json_object *object = create_change("moved", state->id);
+			describe_position(state, object);
+			json_object_array_add(changes, object);
+		}
+
+		json_object *object = create_change("property", state->id);
+		if (describe_properties(state, prev, object)) {
+			json_object_array_add(changes, object);
+		} else {
+			json_object_put(object);
+		}
+	}
+
+	for (size_t k = 0; k < new->length; ++k) {
+		new->nodes[k].prev = NULL;
+	}
+
+	if (json_object_array_length(changes) == 0) {
+		json_object_put(changes);
+		return NULL;
+	}
+	return changes;
+}
+
+json_object *ipc_tree_diff(void) {
+	struct tree_snapshot *new = snapshot_create();
+	if (!new) {
+		sway_log(SWAY_ERROR, "Unable to take tree snapshot");
+		return NULL;
+	}
+
+	struct tree_snapshot *old = snapshot;
+	snapshot = new;
+	if (!old) {
+		return NULL;
+	}
+
+	json_object *changes = snapshot_diff(old, new);
+	snapshot_destroy(old);
+	if (!changes) {
+		return NULL;
+	}
+
+	json_object *event = json_object_new_object();
+	json_object_object_add(event, "sequence",
+			json_object_new_int64((int64_t)++sequence));
+	json_object_object_add(event, "changes", changes);
+	return event;
+}
+
+uint64_t ipc_tree_sequence(void) {
+	return sequence;
+}
+
+void ipc_tree_reset(void) {
+	snapshot_destroy(snapshot);
+	snapshot = NULL;
+}
@@ -3,50 +3,29 @@
 #include "log.h"
 #include "sway/scene_descriptor.h"
 
-struct scene_descriptor {
-	void *data;
-	struct wlr_addon addon;
-};
-
 static const struct wlr_addon_interface addon_interface;
 
-static struct scene_descriptor *scene_node_get_descriptor(
-		struct wlr_scene_node *node, enum sway_scene_descriptor_type type) {
-	struct wlr_addon *addon = wlr_addon_find(&node->addons, (void *)type, &addon_interface);
-	if (!addon) {
-		return NULL;
-	}
-
-	struct scene_descriptor *desc = wl_container_of(addon, desc, addon);
-	return desc;
-}
-
-static void descriptor_destroy(struct scene_descriptor *desc) {
+static void descriptor_destroy(struct sway_scene_descriptor *desc) {
 	wlr_addon_finish(&desc->addon);
+	desc->node->data = NULL;
 	free(desc);
 }
 
-void *scene_descriptor_try_get(struct wlr_scene_node *node,
-		enum sway_scene_descriptor_type type) {
-	struct scene_descriptor *desc = scene_node_get_descriptor(node, type);
-	if (!desc) {
-		return NULL;
-	}
-
-	return desc->data;
-}
-
 void scene_descriptor_destroy(struct wlr_scene_node *node,
 		enum sway_scene_descriptor_type type) {
-	struct scene_descriptor *desc = scene_node_get_descriptor(node, type);
+	struct sway_scene_descriptor *desc = scene_descriptor_get(node);
 	if (!desc) {
 		return;
 	}
-	descriptor_destroy(desc);
+	desc->types &= ~(1u << type);
+	desc->data[type] = NULL;
+	if (!desc->types) {
+		descriptor_destroy(desc);
+	}
 }
 
 static void addon_handle_destroy(struct wlr_addon *addon) {
-	struct scene_descriptor *desc = wl_container_of(addon, desc, addon);
+	struct sway_scene_descriptor *desc = wl_container_of(addon, desc, addon);
 	descriptor_destroy(desc);
 }
 
@@ -57,13 +36,19 @@ static const struct wlr_addon_interface addon_interface = {
 
 bool scene_descriptor_assign(struct wlr_scene_node *node,
 		enum sway_scene_descriptor_type type, void *data) {
-	struct scene_descriptor *desc = calloc(1, sizeof(*desc));
+	struct sway_scene_descriptor *desc = scene_descriptor_get(node);
 	if (!desc) {
-		sway_log(SWAY_ERROR, "Could not allocate a scene descriptor");
-		return false;
+		desc = calloc(1, sizeof(*desc));
+		if (!desc) {
+			sway_log(SWAY_ERROR, "Could not allocate a scene descriptor");
+			return false;
+		}
+		desc->node = node;
+		wlr_addon_init(&desc->addon, &node->addons, NULL, &addon_interface);
+		node->data = desc;
 	}
 
-	wlr_addon_init(&desc->addon, &node->addons, (void *)type, &addon_interface);
-	desc->data = data;
+	desc->types |= 1u << type;
+	desc->data[type] = data;
 	return true;
 }
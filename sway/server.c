@@ -57,10 +57,12 @@
 #include "list.h"
 #include "log.h"
 #include "sway/config.h"
+#include "sway/desktop/transaction.h"
 #include "sway/desktop/idle_inhibit_v1.h"
 #include "sway/input/input-manager.h"
 #include "sway/output.h"
 #include "sway/server.h"
+#include "sway/sway_text_node.h"
 #include "sway/input/cursor.h"
 #include "sway/tree/root.h"
 #include "sway/tree/workspace.h"
@@ -705,6 +707,13 @@ bool server_init(struct sway_server *server) {
 		return false;
 	}
 
+	server->txn_instruction_pool = create_list();
+	server->txn_list_pool = create_list();
+	if (!server->txn_instruction_pool || !server->txn_list_pool) {
+		sway_log(SWAY_ERROR, "Failed to create transaction pools");
+		return false;
+	}
+
 	server->input = input_manager_create(server);
 	if (!server->input) {
 		sway_log(SWAY_ERROR, "Failed to create input manager");
@@ -753,6 +762,8 @@ void server_fini(struct sway_server *server) {
 	wlr_backend_destroy(server->backend);
 	wl_display_destroy(server->wl_display);
 	list_free(server->dirty_nodes);
+	transaction_pool_finish();
+	sway_text_node_cache_finish();
 	free(server->socket);
 }
 
@@ -0,0 +1,33 @@
+#include <time.h>
+#include "sway/stats.h"
+
+const uint64_t sway_histogram_bounds_usec[SWAY_HISTOGRAM_BUCKETS - 1] = {
+	10, 50, 100, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000,
+};
+
+void histogram_add(struct sway_histogram *histogram, uint64_t usec) {
+	size_t bucket = 0;
+	while (bucket < SWAY_HISTOGRAM_BUCKETS - 1 &&
+			usec > sway_histogram_bounds_usec[bucket]) {
+		bucket++;
+	}
+	histogram->buckets[bucket]++;
+	histogram->count++;
+	histogram->total_usec += usec;
+	if (usec > histogram->max_usec) {
+		histogram->max_usec = usec;
+	}
+}
+
+uint64_t stats_elapsed_usec(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	int64_t usec = (int64_t)(now.tv_sec - start->tv_sec) * 1000000 +
+		(now.tv_nsec - start->tv_nsec) / 1000;
+	return usec > 0 ? (uint64_t)usec : 0;
+}
+
+void histogram_add_since(struct sway_histogram *histogram,
+		const struct timespec *start) {
+	histogram_add(histogram, stats_elapsed_usec(start));
+}
@@ -8,6 +8,7 @@
 #include "log.h"
 #include "pango.h"
 #include "sway/config.h"
+#include "sway/server.h"
 #include "sway/sway_text_node.h"
 
 struct cairo_buffer {
@@ -52,10 +53,84 @@ struct text_buffer {
 	float scale;
 	enum wl_output_subpixel subpixel;
 
+	bool dirty; // waiting in dirty_buffers to be rasterized
+	struct wl_list dirty_link;
+
+	// Shaped text, kept between measuring and rendering
+	PangoLayout *layout;
+	PangoAttrList *attrs; // markup attributes, without scale
+	double layout_scale;
+
 	struct wl_listener outputs_update;
 	struct wl_listener destroy;
 };
 
+// Text buffers whose properties changed since they were last rasterized
+static struct wl_list dirty_buffers = { &dirty_buffers, &dirty_buffers };
+static struct wl_event_source *flush_idle = NULL;
+
+// Context of all text node layouts, with the font options of the last render
+static PangoContext *text_context = NULL;
+static enum wl_output_subpixel text_context_subpixel;
+
+static void text_context_set_subpixel(enum wl_output_subpixel subpixel) {
+	cairo_font_options_t *fo = cairo_font_options_create();
+	cairo_font_options_set_hint_style(fo, CAIRO_HINT_STYLE_FULL);
+	if (subpixel == WL_OUTPUT_SUBPIXEL_NONE || subpixel == WL_OUTPUT_SUBPIXEL_UNKNOWN) {
+		cairo_font_options_set_antialias(fo, CAIRO_ANTIALIAS_GRAY);
+	} else {
+		cairo_font_options_set_antialias(fo, CAIRO_ANTIALIAS_SUBPIXEL);
+		cairo_font_options_set_subpixel_order(fo, to_cairo_subpixel_order(subpixel));
+	}
+	pango_cairo_context_set_font_options(text_context, fo);
+	cairo_font_options_destroy(fo);
+	text_context_subpixel = subpixel;
+}
+
+static PangoContext *get_text_context(void) {
+	if (!text_context) {
+		PangoFontMap *fontmap = pango_cairo_font_map_get_default();
+		text_context = pango_font_map_create_context(fontmap);
+		pango_context_set_round_glyph_positions(text_context, false);
+		text_context_set_subpixel(WL_OUTPUT_SUBPIXEL_UNKNOWN);
+	}
+	return text_context;
+}
+
+/**
+ * Shape the text at scale 1. The layout is kept for rendering, which only
+ * shapes it again if the scale, font or font options changed.
+ */
+static void text_layout_update(struct text_buffer *buffer) {
+	if (!buffer->layout) {
+		buffer->layout = pango_layout_new(get_text_context());
+		pango_layout_set_single_paragraph_mode(buffer->layout, 1);
+	}
+	if (buffer->attrs) {
+		pango_attr_list_unref(buffer->attrs);
+	}
+	pango_layout_set_font_description(buffer->layout, config->font_description);
+	buffer->attrs = set_pango_layout_text(buffer->layout, buffer->text,
+		buffer->props.pango_markup);
+	set_pango_layout_scale(buffer->layout, buffer->attrs, 1);
+	buffer->layout_scale = 1;
+}
+
+static void text_layout_prepare(struct text_buffer *buffer, double scale,
+		enum wl_output_subpixel subpixel) {
+	if (!buffer->layout || !pango_font_description_equal(config->font_description,
+			pango_layout_get_font_description(buffer->layout))) {
+		text_layout_update(buffer);
+	}
+	if (subpixel != text_context_subpixel) {
+		text_context_set_subpixel(subpixel);
+	}
+	if (scale != buffer->layout_scale) {
+		set_pango_layout_scale(buffer->layout, buffer->attrs, scale);
+		buffer->layout_scale = scale;
+	}
+}
+
 static int get_text_width(struct sway_text_node *props) {
 	int width = props->width;
 	if (props->max_width >= 0) {
@@ -64,32 +139,200 @@ static int get_text_width(struct sway_text_node *props) {
 	return MAX(width, 0);
 }
 
-static void render_backing_buffer(struct text_buffer *buffer) {
-	if (!buffer->visible) {
+/**
+ * Everything that affects the pixels of a rendered text buffer. Sizes are in
+ * logical pixels.
+ */
+struct text_cache_key {
+	const char *text;
+	const char *font;
+	bool pango_markup;
+	float scale;
+	enum wl_output_subpixel subpixel;
+	float color[4];
+	float background[4];
+	int width, height;
+	int baseline_offset; // distance the text is moved down by
+};
+
+struct text_cache_entry {
+	struct text_cache_key key; // owns text and font
+	uint32_t hash;
+	struct wlr_buffer *buffer; // locked by the cache
+	size_t bytes;
+
+	struct wl_list bucket_link;
+	struct wl_list lru_link; // text_cache.lru, most recently used first
+};
+
+/**
+ * Rendered text buffers shared by all text nodes, so that nodes showing the
+ * same text in the same colors reuse one buffer. Once the pixel data of the
+ * cached buffers exceeds TEXT_CACHE_BUDGET, the least recently used ones are
+ * released. Buffers still shown by a scene node stay alive until replaced.
+ */
+#define TEXT_CACHE_BUDGET (8 * 1024 * 1024)
+
+static struct {
+	struct wl_list *buckets;
+	size_t capacity; // power of two
+	size_t length;
+	size_t bytes;
+	struct wl_list lru;
+} text_cache = {
+	.lru = { &text_cache.lru, &text_cache.lru },
+};
+
+static uint32_t hash_bytes(uint32_t hash, const void *data, size_t len) {
+	const unsigned char *bytes = data;
+	for (size_t i = 0; i < len; ++i) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static uint32_t text_cache_hash(const struct text_cache_key *key) {
+	uint32_t hash = 2166136261u;
+	hash = hash_bytes(hash, key->text, strlen(key->text) + 1);
+	hash = hash_bytes(hash, key->font, strlen(key->font) + 1);
+	hash = hash_bytes(hash, &key->pango_markup, sizeof(key->pango_markup));
+	hash = hash_bytes(hash, &key->scale, sizeof(key->scale));
+	hash = hash_bytes(hash, &key->subpixel, sizeof(key->subpixel));
+	hash = hash_bytes(hash, key->color, sizeof(key->color));
+	hash = hash_bytes(hash, key->background, sizeof(key->background));
+	hash = hash_bytes(hash, &key->width, sizeof(key->width));
+	hash = hash_bytes(hash, &key->height, sizeof(key->height));
+	hash = hash_bytes(hash, &key->baseline_offset, sizeof(key->baseline_offset));
+	return hash;
+}
+
+static bool text_cache_key_equal(const struct text_cache_key *a,
+		const struct text_cache_key *b) {
+	return a->pango_markup == b->pango_markup && a->scale == b->scale &&
+		a->subpixel == b->subpixel && a->width == b->width &&
+		a->height == b->height && a->baseline_offset == b->baseline_offset &&
+		memcmp(a->color, b->color, sizeof(a->color)) == 0 &&
+		memcmp(a->background, b->background, sizeof(a->background)) == 0 &&
+		strcmp(a->text, b->text) == 0 && strcmp(a->font, b->font) == 0;
+}
+
+static struct text_cache_entry *text_cache_find(
+		const struct text_cache_key *key, uint32_t hash) {
+	if (text_cache.capacity == 0) {
+		return NULL;
+	}
+	struct wl_list *bucket = &text_cache.buckets[hash & (text_cache.capacity - 1)];
+	struct text_cache_entry *entry;
+	wl_list_for_each(entry, bucket, bucket_link) {
+		if (entry->hash == hash && text_cache_key_equal(&entry->key, key)) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static void text_cache_entry_destroy(struct text_cache_entry *entry) {
+	wl_list_remove(&entry->bucket_link);
+	wl_list_remove(&entry->lru_link);
+	text_cache.length--;
+	text_cache.bytes -= entry->bytes;
+	server.text_cache_stats.entries = text_cache.length;
+	server.text_cache_stats.bytes = text_cache.bytes;
+
+	wlr_buffer_unlock(entry->buffer);
+	free((char *)entry->key.text);
+	free((char *)entry->key.font);
+	free(entry);
+}
+
+static bool text_cache_grow(void) {
+	size_t capacity = text_cache.capacity ? text_cache.capacity * 2 : 64;
+	struct wl_list *buckets = calloc(capacity, sizeof(*buckets));
+	if (!buckets) {
+		return false;
+	}
+	for (size_t i = 0; i < capacity; ++i) {
+		wl_list_init(&buckets[i]);
+	}
+	for (size_t i = 0; i < text_cache.capacity; ++i) {
+		struct text_cache_entry *entry, *tmp;
+		wl_list_for_each_safe(entry, tmp, &text_cache.buckets[i], bucket_link) {
+			wl_list_remove(&entry->bucket_link);
+			wl_list_insert(&buckets[entry->hash & (capacity - 1)],
+				&entry->bucket_link);
+		}
+	}
+	free(text_cache.buckets);
+	text_cache.buckets = buckets;
+	text_cache.capacity = capacity;
+	return true;
+}
+
+/**
+ * Add a rendered buffer to the cache, which takes its own lock on it.
+ */
+static void text_cache_insert(const struct text_cache_key *key, uint32_t hash,
+		struct wlr_buffer *buffer) {
+	if (text_cache.length >= text_cache.capacity && !text_cache_grow()) {
 		return;
 	}
 
-	if (buffer->props.max_width == 0) {
-		wlr_scene_buffer_set_buffer(buffer->buffer_node, NULL);
+	struct text_cache_entry *entry = calloc(1, sizeof(*entry));
+	if (!entry) {
 		return;
 	}
+	entry->key = *key;
+	entry->key.text = strdup(key->text);
+	entry->key.font = strdup(key->font);
+	if (!entry->key.text || !entry->key.font) {
+		free((char *)entry->key.text);
+		free((char *)entry->key.font);
+		free(entry);
+		return;
+	}
+	entry->hash = hash;
+	entry->buffer = wlr_buffer_lock(buffer);
+	entry->bytes = (size_t)buffer->width * buffer->height * 4;
+
+	wl_list_insert(&text_cache.buckets[hash & (text_cache.capacity - 1)],
+		&entry->bucket_link);
+	wl_list_insert(&text_cache.lru, &entry->lru_link);
+	text_cache.length++;
+	text_cache.bytes += entry->bytes;
+
+	while (text_cache.bytes > TEXT_CACHE_BUDGET) {
+		struct text_cache_entry *oldest =
+			wl_container_of(text_cache.lru.prev, oldest, lru_link);
+		text_cache_entry_destroy(oldest);
+		server.text_cache_stats.evictions++;
+	}
+	server.text_cache_stats.entries = text_cache.length;
+	server.text_cache_stats.bytes = text_cache.bytes;
+}
 
-	float scale = buffer->scale;
-	int width = ceil(get_text_width(&buffer->props) * scale);
-	int height = ceil(buffer->props.height * scale);
-	float *color = (float *)&buffer->props.color;
-	float *background = (float *)&buffer->props.background;
-	PangoContext *pango = NULL;
+void sway_text_node_cache_finish(void) {
+	while (!wl_list_empty(&text_cache.lru)) {
+		struct text_cache_entry *entry =
+			wl_container_of(text_cache.lru.next, entry, lru_link);
+		text_cache_entry_destroy(entry);
+	}
+	free(text_cache.buckets);
+	text_cache.buckets = NULL;
+	text_cache.capacity = 0;
 
-	cairo_font_options_t *fo = cairo_font_options_create();
-	cairo_font_options_set_hint_style(fo, CAIRO_HINT_STYLE_FULL);
-	enum wl_output_subpixel subpixel = buffer->subpixel;
-	if (subpixel == WL_OUTPUT_SUBPIXEL_NONE || subpixel == WL_OUTPUT_SUBPIXEL_UNKNOWN) {
-		cairo_font_options_set_antialias(fo, CAIRO_ANTIALIAS_GRAY);
-	} else {
-		cairo_font_options_set_antialias(fo, CAIRO_ANTIALIAS_SUBPIXEL);
-		cairo_font_options_set_subpixel_order(fo, to_cairo_subpixel_order(subpixel));
+	if (text_context) {
+		g_object_unref(text_context);
+		text_context = NULL;
 	}
+}
+
+static struct wlr_buffer *render_text_buffer(struct text_buffer *buffer,
+		const struct text_cache_key *key) {
+	float scale = key->scale;
+	int width = ceil(key->width * scale);
+	int height = ceil(key->height * scale);
+	const float *color = key->color;
+	const float *background = key->background;
 
 	cairo_surface_t *surface = cairo_image_surface_create(
 			CAIRO_FORMAT_ARGB32, width, height);
@@ -97,57 +340,147 @@ static void render_backing_buffer(struct text_buffer *buffer) {
 	if (status != CAIRO_STATUS_SUCCESS) {
 		sway_log(SWAY_ERROR, "cairo_image_surface_create failed: %s",
 			cairo_status_to_string(status));
-		goto err;
+		cairo_surface_destroy(surface);
+		return NULL;
 	}
 
 	struct cairo_buffer *cairo_buffer = calloc(1, sizeof(*cairo_buffer));
 	if (!cairo_buffer) {
 		sway_log(SWAY_ERROR, "cairo_buffer allocation failed");
-		goto err;
+		cairo_surface_destroy(surface);
+		return NULL;
 	}
 
 	cairo_t *cairo = cairo_create(surface);
 	if (!cairo) {
 		sway_log(SWAY_ERROR, "cairo_create failed");
 		free(cairo_buffer);
-		goto err;
+		cairo_surface_destroy(surface);
+		return NULL;
 	}
 
 	cairo_set_antialias(cairo, CAIRO_ANTIALIAS_BEST);
-	cairo_set_font_options(cairo, fo);
-	pango = pango_cairo_create_context(cairo);
 
 	cairo_set_source_rgba(cairo, background[0], background[1], background[2], background[3]);
 	cairo_rectangle(cairo, 0, 0, width, height);
 	cairo_fill(cairo);
 
 	cairo_set_source_rgba(cairo, color[0], color[1], color[2], color[3]);
-	cairo_move_to(cairo, 0, (config->font_baseline - buffer->props.baseline) * scale);
+	cairo_move_to(cairo, 0, key->baseline_offset * scale);
 
-	render_text(cairo, config->font_description, scale, buffer->props.pango_markup,
-		"%s", buffer->text);
+	text_layout_prepare(buffer, scale, key->subpixel);
+	pango_cairo_show_layout(cairo, buffer->layout);
 
 	cairo_surface_flush(surface);
 
 	wlr_buffer_init(&cairo_buffer->base, &cairo_buffer_impl, width, height);
 	cairo_buffer->surface = surface;
 	cairo_buffer->cairo = cairo;
+	return &cairo_buffer->base;
+}
+
+/**
+ * Return a locked buffer with the rendered text, from the cache if an
+ * identical one was rendered before. The caller must unlock it.
+ */
+static struct wlr_buffer *text_cache_acquire(struct text_buffer *text_buffer,
+		const struct text_cache_key *key) {
+	uint32_t hash = text_cache_hash(key);
+	struct text_cache_entry *entry = text_cache_find(key, hash);
+	if (entry) {
+		server.text_cache_stats.hits++;
+		wl_list_remove(&entry->lru_link);
+		wl_list_insert(&text_cache.lru, &entry->lru_link);
+		return wlr_buffer_lock(entry->buffer);
+	}
+
+	server.text_cache_stats.misses++;
+	struct wlr_buffer *buffer = render_text_buffer(text_buffer, key);
+	if (!buffer) {
+		return NULL;
+	}
+	// Lock for the caller before the cache may evict it again
+	wlr_buffer_lock(buffer);
+	wlr_buffer_drop(buffer);
+	text_cache_insert(key, hash, buffer);
+	return buffer;
+}
 
-	wlr_scene_buffer_set_buffer(buffer->buffer_node, &cairo_buffer->base);
-	wlr_buffer_drop(&cairo_buffer->base);
+static void render_backing_buffer(struct text_buffer *buffer) {
+	if (!buffer->visible) {
+		return;
+	}
+
+	if (buffer->props.max_width == 0) {
+		wlr_scene_buffer_set_buffer(buffer->buffer_node, NULL);
+		return;
+	}
+
+	struct text_cache_key key = {
+		.text = buffer->text,
+		.font = config->font,
+		.pango_markup = buffer->props.pango_markup,
+		.scale = buffer->scale,
+		.subpixel = buffer->subpixel,
+		.width = get_text_width(&buffer->props),
+		.height = buffer->props.height,
+		.baseline_offset = config->font_baseline - buffer->props.baseline,
+	};
+	memcpy(key.color, &buffer->props.color, sizeof(key.color));
+	memcpy(key.background, &buffer->props.background, sizeof(key.background));
+
+	struct wlr_buffer *wlr_buffer = text_cache_acquire(buffer, &key);
+	if (!wlr_buffer) {
+		return;
+	}
+	wlr_scene_buffer_set_buffer(buffer->buffer_node, wlr_buffer);
+	wlr_buffer_unlock(wlr_buffer);
 
 	pixman_region32_t opaque;
 	pixman_region32_init(&opaque);
-	if (background[3] == 1) {
+	if (key.background[3] == 1) {
 		pixman_region32_union_rect(&opaque, &opaque, 0, 0,
-			get_text_width(&buffer->props), buffer->props.height);
+			key.width, key.height);
 	}
 	wlr_scene_buffer_set_opaque_region(buffer->buffer_node, &opaque);
 	pixman_region32_fini(&opaque);
+}
 
-err:
-	if (pango) g_object_unref(pango);
-	cairo_font_options_destroy(fo);
+void sway_text_node_flush(void) {
+	// Rasterizing may update the outputs of a node and dirty it again
+	while (!wl_list_empty(&dirty_buffers)) {
+		struct text_buffer *buffer =
+			wl_container_of(dirty_buffers.next, buffer, dirty_link);
+		wl_list_remove(&buffer->dirty_link);
+		buffer->dirty = false;
+		render_backing_buffer(buffer);
+	}
+}
+
+static void handle_flush_idle(void *data) {
+	flush_idle = NULL;
+	sway_text_node_flush();
+}
+
+/**
+ * Rasterize the buffer once all pending property changes have been made,
+ * at the latest when the event loop goes idle.
+ */
+static void text_buffer_mark_dirty(struct text_buffer *buffer) {
+	if (buffer->dirty) {
+		server.text_renders_coalesced++;
+		return;
+	}
+	buffer->dirty = true;
+	wl_list_insert(dirty_buffers.prev, &buffer->dirty_link);
+
+	if (!flush_idle) {
+		flush_idle = wl_event_loop_add_idle(server.wl_event_loop,
+			handle_flush_idle, NULL);
+		if (!flush_idle) {
+			sway_text_node_flush();
+		}
+	}
 }
 
 static void handle_outputs_update(struct wl_listener *listener, void *data) {
@@ -181,7 +514,7 @@ static void handle_outputs_update(struct wl_listener *listener, void *data) {
 	if (scale != buffer->scale || subpixel != buffer->subpixel) {
 		buffer->scale = scale;
 		buffer->subpixel = subpixel;
-		render_backing_buffer(buffer);
+		text_buffer_mark_dirty(buffer);
 	}
 }
 
@@ -190,7 +523,14 @@ static void handle_destroy(struct wl_listener *listener, void *data) {
 
 	wl_list_remove(&buffer->outputs_update.link);
 	wl_list_remove(&buffer->destroy.link);
+	if (buffer->dirty) {
+		wl_list_remove(&buffer->dirty_link);
+	}
 
+	if (buffer->layout) {
+		g_object_unref(buffer->layout);
+		pango_attr_list_unref(buffer->attrs);
+	}
 	free(buffer->text);
 	free(buffer);
 }
@@ -198,24 +538,12 @@ static void handle_destroy(struct wl_listener *listener, void *data) {
 static void text_calc_size(struct text_buffer *buffer) {
 	struct sway_text_node *props = &buffer->props;
 
-	cairo_surface_t *recorder = cairo_recording_surface_create(
-		CAIRO_CONTENT_COLOR_ALPHA, NULL);
-	cairo_t *c = cairo_create(recorder);
-	cairo_surface_destroy(recorder);
-	if (cairo_status(c) != CAIRO_STATUS_SUCCESS) {
-		sway_log(SWAY_ERROR, "cairo_t allocation failed: %s",
-			cairo_status_to_string(cairo_status(c)));
-		goto out;
-	}
-
-	cairo_set_antialias(c, CAIRO_ANTIALIAS_BEST);
-	get_text_size(c, config->font_description, &props->width, NULL,
-		&props->baseline, 1, props->pango_markup, "%s", buffer->text);
+	text_layout_update(buffer);
+	pango_layout_get_pixel_size(buffer->layout, &props->width, NULL);
+	props->baseline = pango_layout_get_baseline(buffer->layout) / PANGO_SCALE;
 
 	wlr_scene_buffer_set_dest_size(buffer->buffer_node,
 		get_text_width(props), props->height);
-out:
-	cairo_destroy(c);
 }
 
 struct sway_text_node *sway_text_node_create(struct wlr_scene_tree *parent,
@@ -263,7 +591,7 @@ void sway_text_node_set_color(struct sway_text_node *node, float color[4]) {
 	memcpy(&node->color, color, sizeof(*color) * 4);
 	struct text_buffer *buffer = wl_container_of(node, buffer, props);
 
-	render_backing_buffer(buffer);
+	text_buffer_mark_dirty(buffer);
 }
 
 void sway_text_node_set_text(struct sway_text_node *node, char *text) {
@@ -281,7 +609,7 @@ void sway_text_node_set_text(struct sway_text_node *node, char *text) {
 	buffer->text = new_text;
 
 	text_calc_size(buffer);
-	render_backing_buffer(buffer);
+	text_buffer_mark_dirty(buffer);
 }
 
 void sway_text_node_set_max_width(struct sway_text_node *node, int max_width) {
@@ -292,7 +620,7 @@ void sway_text_node_set_max_width(struct sway_text_node *node, int max_width) {
 	buffer->props.max_width = max_width;
 	wlr_scene_buffer_set_dest_size(buffer->buffer_node,
 		get_text_width(&buffer->props), buffer->props.height);
-	render_backing_buffer(buffer);
+	text_buffer_mark_dirty(buffer);
 }
 
 void sway_text_node_set_background(struct sway_text_node *node, float background[4]) {
@@ -301,5 +629,5 @@ void sway_text_node_set_background(struct sway_text_node *node, float background
 		return;
 	}
 	memcpy(&node->background, background, sizeof(*background) * 4);
-	render_backing_buffer(buffer);
+	text_buffer_mark_dirty(buffer);
 }
@@ -4,9 +4,11 @@
 #include <string.h>
 #include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_output_layout.h>
+#include "sway/desktop/transaction.h"
 #include "sway/tree/arrange.h"
 #include "sway/tree/container.h"
 #include "sway/output.h"
+#include "sway/server.h"
 #include "sway/tree/workspace.h"
 #include "sway/tree/view.h"
 #include "list.h"
@@ -246,19 +248,30 @@ static void arrange_children(list_t *children,
 	}
 }
 
+/**
+ * Only containers whose layout actually changed are put into the next
+ * transaction, so that unrelated views are neither configured nor frozen.
+ */
+static void arrange_set_dirty(struct sway_container *container) {
+	server.arrange_stats.containers_arranged++;
+	if (transaction_set_dirty_if_changed(container)) {
+		server.arrange_stats.containers_dirtied++;
+	}
+}
+
 void arrange_container(struct sway_container *container) {
 	if (config->reloading) {
 		return;
 	}
 	if (container->view) {
 		view_autoconfigure(container->view);
-		node_set_dirty(&container->node);
+		arrange_set_dirty(container);
 		return;
 	}
 	struct wlr_box box;
 	container_get_box(container, &box);
 	arrange_children(container->pending.children, container->pending.layout, &box);
-	node_set_dirty(&container->node);
+	arrange_set_dirty(container);
 }
 
 void arrange_workspace(struct sway_workspace *workspace) {
@@ -17,6 +17,7 @@
 #include "sway/output.h"
 #include "sway/server.h"
 #include "sway/tree/arrange.h"
+#include "sway/tree/root.h"
 #include "sway/tree/view.h"
 #include "sway/tree/workspace.h"
 #include "sway/xdg_decoration.h"
@@ -113,6 +114,7 @@ struct sway_container *container_create(struct sway_view *view) {
 	c->view = view;
 	c->alpha = 1.0f;
 	c->marks = create_list();
+	root_index_container(c);
 
 	wl_signal_init(&c->events.destroy);
 	wl_signal_emit_mutable(&root->events.new_node, &c->node);
@@ -491,6 +493,7 @@ void container_begin_destroy(struct sway_container *con) {
 
 	node_set_dirty(&con->node);
 	con->node.destroying = true;
+	root_unindex_container(con);
 
 	if (con->scratchpad) {
 		root_scratchpad_remove_container(con);
@@ -1239,6 +1242,7 @@ static void container_fullscreen_global(struct sway_container *con) {
 	}
 
 	con->pending.fullscreen_mode = FULLSCREEN_GLOBAL;
+	root->tree_generation++;
 	container_end_mouse_operation(con);
 	ipc_event_window(con, "fullscreen_mode");
 }
@@ -1280,6 +1284,7 @@ void container_fullscreen_disable(struct sway_container *con) {
 	}
 
 	con->pending.fullscreen_mode = FULLSCREEN_NONE;
+	root->tree_generation++;
 	container_end_mouse_operation(con);
 	ipc_event_window(con, "fullscreen_mode");
 
@@ -1435,6 +1440,7 @@ void container_insert_child(struct sway_container *parent,
 		container_detach(child);
 	}
 	list_insert(parent->pending.children, i, child);
+	root->tree_generation++;
 	child->pending.parent = parent;
 	child->pending.workspace = parent->pending.workspace;
 	container_for_each_child(child, set_workspace, NULL);
@@ -1450,6 +1456,7 @@ void container_add_sibling(struct sway_container *fixed,
 	list_t *siblings = container_get_siblings(fixed);
 	int index = list_find(siblings, fixed);
 	list_insert(siblings, index + after, active);
+	root->tree_generation++;
 	active->pending.parent = fixed->pending.parent;
 	active->pending.workspace = fixed->pending.workspace;
 	container_for_each_child(active, set_workspace, NULL);
@@ -1463,6 +1470,7 @@ void container_add_child(struct sway_container *parent,
 		container_detach(child);
 	}
 	list_add(parent->pending.children, child);
+	root->tree_generation++;
 	child->pending.parent = parent;
 	child->pending.workspace = parent->pending.workspace;
 	container_for_each_child(child, set_workspace, NULL);
@@ -1500,6 +1508,7 @@ void container_detach(struct sway_container *child) {
 	child->pending.parent = NULL;
 	child->pending.workspace = NULL;
 	container_for_each_child(child, set_workspace, NULL);
+	root->tree_generation++;
 
 	if (old_parent) {
 		container_update_representation(old_parent);
@@ -1613,18 +1622,18 @@ bool container_is_transient_for(struct sway_container *child,
 		view_is_transient_for(child->view, ancestor->view);
 }
 
-static bool find_by_mark_iterator(struct sway_container *con, void *data) {
-	char *mark = data;
-	return container_has_mark(con, mark);
+static void container_marks_changed(struct sway_container *con) {
+	if (con->view) {
+		con->view->criteria_serials[CRITERIA_DEP_MARKS]++;
+	}
 }
 
 struct sway_container *container_find_mark(char *mark) {
-	return root_find_container(find_by_mark_iterator, mark);
+	return root_find_container_by_mark(mark);
 }
 
 bool container_find_and_unmark(char *mark) {
-	struct sway_container *con = root_find_container(
-		find_by_mark_iterator, mark);
+	struct sway_container *con = root_find_container_by_mark(mark);
 	if (!con) {
 		return false;
 	}
@@ -1632,8 +1641,10 @@ bool container_find_and_unmark(char *mark) {
 	for (int i = 0; i < con->marks->length; ++i) {
 		char *con_mark = con->marks->items[i];
 		if (strcmp(con_mark, mark) == 0) {
+			root_unindex_mark(con, con_mark);
 			free(con_mark);
 			list_del(con->marks, i);
+			container_marks_changed(con);
 			container_update_marks(con);
 			ipc_event_window(con, "mark");
 			return true;
@@ -1644,9 +1655,11 @@ bool container_find_and_unmark(char *mark) {
 
 void container_clear_marks(struct sway_container *con) {
 	for (int i = 0; i < con->marks->length; ++i) {
+		root_unindex_mark(con, con->marks->items[i]);
 		free(con->marks->items[i]);
 	}
 	con->marks->length = 0;
+	container_marks_changed(con);
 	ipc_event_window(con, "mark");
 }
 
@@ -1661,7 +1674,12 @@ bool container_has_mark(struct sway_container *con, char *mark) {
 }
 
 void container_add_mark(struct sway_container *con, char *mark) {
-	list_add(con->marks, strdup(mark));
+	char *copy = strdup(mark);
+	list_add(con->marks, copy);
+	if (!con->node.destroying) {
+		root_index_mark(con, copy);
+	}
+	container_marks_changed(con);
 	ipc_event_window(con, "mark");
 }
 
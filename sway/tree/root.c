@@ -79,6 +79,8 @@ struct sway_root *root_create(struct wl_display *wl_display) {
 }
 
 void root_destroy(struct sway_root *root) {
+	free(root->containers_by_id.slots);
+	free(root->containers_by_mark.slots);
 	list_free(root->scratchpad);
 	list_free(root->non_desktop_outputs);
 	list_free(root->outputs);
@@ -329,3 +331,165 @@ void root_get_box(struct sway_root *root, struct wlr_box *box) {
 	box->width = root->width;
 	box->height = root->height;
 }
+
+static uint32_t container_index_hash_id(size_t id) {
+	uint64_t hash = (uint64_t)id * 0x9e3779b97f4a7c15u;
+	return (uint32_t)(hash >> 32);
+}
+
+static uint32_t container_index_hash_mark(const char *mark) {
+	uint32_t hash = 2166136261u;
+	for (; *mark; ++mark) {
+		hash = (hash ^ (unsigned char)*mark) * 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * Return the slot holding the key, or the unused slot where it would go.
+ */
+static size_t container_index_find(struct sway_container_index *index,
+		uint32_t hash, const char *mark, size_t id) {
+	size_t mask = index->capacity - 1;
+	size_t i = hash & mask;
+	for (;; i = (i + 1) & mask) {
+		struct sway_container_index_slot *slot = &index->slots[i];
+		if (!slot->con) {
+			return i;
+		}
+		if (slot->hash != hash) {
+			continue;
+		}
+		if (mark ? strcmp(slot->mark, mark) == 0 : slot->id == id) {
+			return i;
+		}
+	}
+}
+
+static bool container_index_grow(struct sway_container_index *index) {
+	size_t capacity = index->capacity ? index->capacity * 2 : 64;
+	struct sway_container_index_slot *slots =
+		calloc(capacity, sizeof(*slots));
+	if (!slots) {
+		sway_log(SWAY_ERROR, "Unable to allocate container index");
+		return false;
+	}
+
+	struct sway_container_index old = *index;
+	index->slots = slots;
+	index->capacity = capacity;
+	for (size_t i = 0; i < old.capacity; ++i) {
+		struct sway_container_index_slot *slot = &old.slots[i];
+		if (slot->con) {
+			size_t j = container_index_find(index, slot->hash,
+				slot->mark, slot->id);
+			index->slots[j] = *slot;
+		}
+	}
+	free(old.slots);
+	return true;
+}
+
+static void container_index_insert(struct sway_container_index *index,
+		uint32_t hash, const char *mark, size_t id,
+		struct sway_container *con) {
+	// Keep the load factor at or below one half
+	if ((index->length + 1) * 2 > index->capacity &&
+			!container_index_grow(index)) {
+		return;
+	}
+	size_t i = container_index_find(index, hash, mark, id);
+	struct sway_container_index_slot *slot = &index->slots[i];
+	if (!slot->con) {
+		index->length++;
+	}
+	*slot = (struct sway_container_index_slot){
+		.hash = hash,
+		.mark = mark,
+		.id = id,
+		.con = con,
+	};
+}
+
+static struct sway_container *container_index_get(
+		struct sway_container_index *index, uint32_t hash,
+		const char *mark, size_t id) {
+	if (!index->length) {
+		return NULL;
+	}
+	return index->slots[container_index_find(index, hash, mark, id)].con;
+}
+
+/**
+ * Remove the key if it maps to con. Later slots of the probe sequence are
+ * shifted back into the hole, so lookups never need tombstones.
+ */
+static void container_index_remove(struct sway_container_index *index,
+		uint32_t hash, const char *mark, size_t id,
+		struct sway_container *con) {
+	if (!index->length) {
+		return;
+	}
+	size_t i = container_index_find(index, hash, mark, id);
+	if (index->slots[i].con != con) {
+		return;
+	}
+
+	size_t mask = index->capacity - 1;
+	for (size_t j = (i + 1) & mask; index->slots[j].con; j = (j + 1) & mask) {
+		size_t home = index->slots[j].hash & mask;
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			index->slots[i] = index->slots[j];
+			i = j;
+		}
+	}
+	index->slots[i] = (struct sway_container_index_slot){0};
+	index->length--;
+}
+
+void root_index_container(struct sway_container *con) {
+	size_t id = con->node.id;
+	container_index_insert(&root->containers_by_id,
+		container_index_hash_id(id), NULL, id, con);
+}
+
+void root_unindex_container(struct sway_container *con) {
+	size_t id = con->node.id;
+	container_index_remove(&root->containers_by_id,
+		container_index_hash_id(id), NULL, id, con);
+	for (int i = 0; i < con->marks->length; ++i) {
+		root_unindex_mark(con, con->marks->items[i]);
+	}
+}
+
+void root_index_mark(struct sway_container *con, const char *mark) {
+	container_index_insert(&root->containers_by_mark,
+		container_index_hash_mark(mark), mark, 0, con);
+}
+
+void root_unindex_mark(struct sway_container *con, const char *mark) {
+	container_index_remove(&root->containers_by_mark,
+		container_index_hash_mark(mark), mark, 0, con);
+}
+
+struct sway_container *root_find_container_by_id(size_t id) {
+	return container_index_get(&root->containers_by_id,
+		container_index_hash_id(id), NULL, id);
+}
+
+struct sway_container *root_find_container_by_mark(const char *mark) {
+	return container_index_get(&root->containers_by_mark,
+		container_index_hash_mark(mark), mark, 0);
+}
+
+void root_for_each_mark(
+		void (*f)(const char *mark, struct sway_container *con, void *data),
+		void *data) {
+	struct sway_container_index *index = &root->containers_by_mark;
+	for (size_t i = 0; i < index->capacity; ++i) {
+		struct sway_container_index_slot *slot = &index->slots[i];
+		if (slot->con) {
+			f(slot->mark, slot->con, data);
+		}
+	}
+}
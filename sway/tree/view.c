@@ -105,7 +105,6 @@ bool view_init(struct sway_view *view, enum sway_view_type type,
 
 	view->type = type;
 	view->impl = impl;
-	view->executed_criteria = create_list();
 	view->allow_request_urgent = true;
 	view->shortcuts_inhibit = SHORTCUTS_INHIBIT_DEFAULT;
 	view->tearing_mode = TEARING_WINDOW_HINT;
@@ -131,7 +130,7 @@ void view_destroy(struct sway_view *view) {
 		return;
 	}
 	wl_list_remove(&view->events.unmap.listener_list);
-	list_free(view->executed_criteria);
+	free(view->criteria_results);
 
 	view_assign_ctx(view, NULL);
 	wlr_scene_node_destroy(&view->image_capture_scene->tree.node);
@@ -556,30 +555,19 @@ void view_close_popups(struct sway_view *view) {
 	}
 }
 
-static bool view_has_executed_criteria(struct sway_view *view,
-		struct criteria *criteria) {
-	for (int i = 0; i < view->executed_criteria->length; ++i) {
-		struct criteria *item = view->executed_criteria->items[i];
-		if (item == criteria) {
-			return true;
-		}
-	}
-	return false;
-}
-
 void view_execute_criteria(struct sway_view *view) {
 	list_t *criterias = criteria_for_view(view, CT_COMMAND);
 	for (int i = 0; i < criterias->length; i++) {
 		struct criteria *criteria = criterias->items[i];
 		sway_log(SWAY_DEBUG, "Checking criteria %s", criteria->raw);
-		if (view_has_executed_criteria(view, criteria)) {
+		if (!criteria_set_executed(criteria, view)) {
 			sway_log(SWAY_DEBUG, "Criteria already executed");
 			continue;
 		}
 		sway_log(SWAY_DEBUG, "for_window '%s' matches view %p, cmd: '%s'",
 				criteria->raw, view, criteria->cmdlist);
-		list_add(view->executed_criteria, criteria);
-		list_t *res_list = execute_command(criteria->cmdlist, NULL, view->container);
+		list_t *res_list = execute_compiled_command(&criteria->compiled_cmdlist,
+			criteria->cmdlist, NULL, view->container);
 		while (res_list->length) {
 			struct cmd_results *res = res_list->items[0];
 			if (res->status != CMD_SUCCESS) {
@@ -972,13 +960,19 @@ void view_map(struct sway_view *view, struct wlr_surface *wlr_surface,
 void view_unmap(struct sway_view *view) {
 	wl_signal_emit_mutable(&view->events.unmap, view);
 
-	view->executed_criteria->length = 0;
+	view->criteria_results_len = 0;
 
 	if (view->urgent_timer) {
 		wl_event_source_remove(view->urgent_timer);
 		view->urgent_timer = NULL;
 	}
 
+	if (view->title_timer) {
+		wl_event_source_remove(view->title_timer);
+		view->title_timer = NULL;
+	}
+	view->title_update_pending = false;
+
 	if (view->ext_foreign_toplevel) {
 		wlr_ext_foreign_toplevel_handle_v1_destroy(view->ext_foreign_toplevel);
 		view->ext_foreign_toplevel = NULL;
@@ -1117,6 +1111,7 @@ void view_update_title(struct sway_view *view, bool force) {
 
 	free(view->container->title);
 	free(view->container->formatted_title);
+	view->criteria_serials[CRITERIA_DEP_TITLE]++;
 
 	size_t len = parse_title_format(view->container, NULL);
 
@@ -1154,6 +1149,52 @@ void view_update_title(struct sway_view *view, bool force) {
 	}
 }
 
+// Roughly one frame at 60Hz
+#define TITLE_UPDATE_INTERVAL_MS 16
+
+static void view_apply_title_change(struct sway_view *view) {
+	clock_gettime(CLOCK_MONOTONIC, &view->title_updated);
+	view_update_title(view, false);
+	view_execute_criteria(view);
+}
+
+static int handle_title_timeout(void *data) {
+	struct sway_view *view = data;
+	view->title_update_pending = false;
+	view_apply_title_change(view);
+	transaction_commit_dirty();
+	return 0;
+}
+
+void view_request_title_update(struct sway_view *view) {
+	if (view->title_update_pending) {
+		server.title_updates_coalesced++;
+		return;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	int64_t elapsed = (now.tv_sec - view->title_updated.tv_sec) * 1000 +
+		(now.tv_nsec - view->title_updated.tv_nsec) / 1000000;
+	if (elapsed >= TITLE_UPDATE_INTERVAL_MS) {
+		view_apply_title_change(view);
+		return;
+	}
+
+	if (!view->title_timer) {
+		view->title_timer = wl_event_loop_add_timer(server.wl_event_loop,
+				handle_title_timeout, view);
+		if (!view->title_timer) {
+			sway_log_errno(SWAY_ERROR, "Unable to create title timer");
+			view_apply_title_change(view);
+			return;
+		}
+	}
+	view->title_update_pending = true;
+	wl_event_source_timer_update(view->title_timer,
+			TITLE_UPDATE_INTERVAL_MS - elapsed);
+}
+
 bool view_is_visible(struct sway_view *view) {
 	if (view->container->node.destroying) {
 		return false;
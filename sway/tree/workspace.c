@@ -887,6 +887,7 @@ static void set_workspace(struct sway_container *container, void *data) {
 static void workspace_attach_tiling(struct sway_workspace *ws,
 		struct sway_container *con) {
 	list_add(ws->tiling, con);
+	root->tree_generation++;
 	con->pending.workspace = ws;
 	container_for_each_child(con, set_workspace, NULL);
 	container_handle_fullscreen_reparent(con);
@@ -931,6 +932,7 @@ void workspace_detach(struct sway_workspace *workspace) {
 		list_del(output->workspaces, index);
 	}
 	workspace->output = NULL;
+	root->tree_generation++;
 
 	node_set_dirty(&workspace->node);
 	node_set_dirty(&output->node);
@@ -949,6 +951,7 @@ struct sway_container *workspace_add_tiling(struct sway_workspace *workspace,
 		con = container_split(con, config->default_layout);
 	}
 	list_add(workspace->tiling, con);
+	root->tree_generation++;
 	con->pending.workspace = workspace;
 	container_for_each_child(con, set_workspace, NULL);
 	container_handle_fullscreen_reparent(con);
@@ -964,6 +967,7 @@ void workspace_add_floating(struct sway_workspace *workspace,
 		container_detach(con);
 	}
 	list_add(workspace->floating, con);
+	root->tree_generation++;
 	con->pending.workspace = workspace;
 	container_for_each_child(con, set_workspace, NULL);
 	container_handle_fullscreen_reparent(con);
@@ -974,6 +978,7 @@ void workspace_add_floating(struct sway_workspace *workspace,
 void workspace_insert_tiling_direct(struct sway_workspace *workspace,
 		struct sway_container *con, int index) {
 	list_insert(workspace->tiling, index, con);
+	root->tree_generation++;
 	con->pending.workspace = workspace;
 	container_for_each_child(con, set_workspace, NULL);
 	container_handle_fullscreen_reparent(con);
@@ -53,6 +53,7 @@ static void swaybar_output_free(struct swaybar_output *output) {
 	wl_output_destroy(output->output);
 	destroy_buffer(&output->buffers[0]);
 	destroy_buffer(&output->buffers[1]);
+	render_reset_damage(output);
 	free_hotspots(&output->hotspots);
 	free_workspaces(&output->workspaces);
 	wl_list_remove(&output->link);
@@ -129,6 +130,7 @@ void destroy_layer_surface(struct swaybar_output *output) {
 	output->layer_surface = NULL;
 	output->width = 0;
 	output->frame_scheduled = false;
+	render_reset_damage(output);
 }
 
 void set_bar_dirty(struct swaybar *bar) {
@@ -351,6 +353,8 @@ static void handle_global(void *data, struct wl_registry *registry,
 		output->wl_name = name;
 		wl_list_init(&output->workspaces);
 		wl_list_init(&output->hotspots);
+		wl_list_init(&output->render_pieces);
+		wl_list_init(&output->text_sizes);
 		wl_list_init(&output->link);
 		if (bar->xdg_output_manager != NULL) {
 			add_xdg_output(output);
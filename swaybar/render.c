@@ -1,12 +1,17 @@
 #include <assert.h>
+#include <inttypes.h>
 #include <linux/input-event-codes.h>
 #include <limits.h>
+#include <math.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include "cairo_util.h"
+#include "log.h"
 #include "pango.h"
 #include "pool-buffer.h"
+#include "stringop.h"
 #include "swaybar/bar.h"
 #include "swaybar/config.h"
 #include "swaybar/i3bar.h"
@@ -29,8 +34,57 @@ struct render_context {
 	cairo_font_options_t *textaa_safe;
 	uint32_t background_color;
 	bool has_transparency;
+
+	uint32_t frame_background;
+	char *font; // the font description as a string, for cache keys
+	int hotspot_width; // of the last status block
+	struct render_segment *segments;
+	int segments_len, segments_capacity;
+};
+
+/**
+ * A rasterized piece of the bar: the tray, the status line or one of its
+ * blocks, a workspace button or the binding mode indicator. Pieces are kept
+ * for as long as every frame uses them, and are only drawn again once their
+ * key, which describes everything they depend on, changes.
+ */
+struct render_piece {
+	struct wl_list link; // swaybar_output::render_pieces
+	char *key;
+	uint32_t id;
+	bool used;
+
+	cairo_surface_t *image; // in buffer pixels, NULL if nothing was drawn
+	int left, width; // of the image, relative to where the piece starts
+	double advance; // how far drawing the piece moved x
+	uint32_t height; // returned by the render function
+
+	// The context as the render function left it
+	uint32_t background_color;
+	bool has_transparency;
+	int hotspot_width;
+};
+
+/**
+ * Where a frame shows a piece. Only the id is compared against the next frame,
+ * the piece itself may be gone by then.
+ */
+struct render_segment {
+	struct render_piece *piece;
+	uint32_t id;
+	int x, width;
 };
 
+struct text_size {
+	struct wl_list link; // swaybar_output::text_sizes
+	char *key;
+	int width, height;
+	bool used;
+};
+
+typedef uint32_t (*render_piece_func_t)(struct render_context *ctx, double *x,
+		void *data);
+
 static void choose_text_aa_mode(struct render_context *ctx, uint32_t fontcolor) {
 	uint32_t salpha = fontcolor & 0xFF;
 	uint32_t balpha = ctx->background_color & 0xFF;
@@ -46,7 +100,230 @@ static void choose_text_aa_mode(struct render_context *ctx, uint32_t fontcolor)
 	cairo_set_operator(ctx->cairo, op);
 }
 
-static uint32_t render_status_line_error(struct render_context *ctx, double *x) {
+static void get_cached_text_size(struct render_context *ctx,
+		int *width, int *height, bool markup, const char *text) {
+	struct swaybar_output *output = ctx->output;
+	char *key = format_str("%d %s\n%d %s", output->scale, ctx->font,
+			markup, text);
+	struct text_size *size = NULL, *iter;
+	wl_list_for_each(iter, &output->text_sizes, link) {
+		if (key && strcmp(iter->key, key) == 0) {
+			size = iter;
+			break;
+		}
+	}
+	if (size) {
+		free(key);
+	} else {
+		size = calloc(1, sizeof(struct text_size));
+		if (!key || !size) {
+			free(key);
+			free(size);
+			get_text_size(ctx->cairo, output->bar->config->font_description,
+					width, height, NULL, 1, markup, "%s", text);
+			return;
+		}
+		get_text_size(ctx->cairo, output->bar->config->font_description,
+				&size->width, &size->height, NULL, 1, markup, "%s", text);
+		size->key = key;
+		wl_list_insert(&output->text_sizes, &size->link);
+	}
+	size->used = true;
+	if (width) {
+		*width = size->width;
+	}
+	if (height) {
+		*height = size->height;
+	}
+}
+
+static char *format_piece_key(struct render_context *ctx,
+		const char *fmt, ...) _SWAY_ATTRIB_PRINTF(2, 3);
+
+/**
+ * Prefixes the description of a piece with the state every piece depends on.
+ */
+static char *format_piece_key(struct render_context *ctx,
+		const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	char *description = vformat_str(fmt, args);
+	va_end(args);
+	if (!description) {
+		return NULL;
+	}
+
+	// Of the background the previous pieces left, only the alpha matters to
+	// choose_text_aa_mode
+	struct swaybar_output *output = ctx->output;
+	char *key = format_str("%d %" PRIu32 " %d %08" PRIx32 " %02" PRIx32 " %s\n%s",
+			output->scale, output->height, output->subpixel,
+			ctx->frame_background, ctx->background_color & 0xFF, ctx->font,
+			description);
+	free(description);
+	return key;
+}
+
+static void destroy_render_piece(struct render_piece *piece) {
+	if (piece->image) {
+		cairo_surface_destroy(piece->image);
+	}
+	free(piece->key);
+	free(piece);
+}
+
+static struct render_piece *draw_render_piece(struct render_context *ctx,
+		char *key, render_piece_func_t render, void *data) {
+	struct swaybar_output *output = ctx->output;
+	struct render_piece *piece = calloc(1, sizeof(struct render_piece));
+	if (!piece) {
+		free(key);
+		return NULL;
+	}
+	static uint32_t last_id = 0;
+	piece->key = key;
+	piece->id = ++last_id;
+
+	// Record the piece over the bar background, as it would be drawn into
+	// the frame, and rasterize just the part of it the piece covers
+	cairo_surface_t *recorder = cairo_recording_surface_create(
+			CAIRO_CONTENT_COLOR_ALPHA, NULL);
+	cairo_t *cairo = cairo_create(recorder);
+	cairo_scale(cairo, output->scale, output->scale);
+	cairo_set_antialias(cairo, CAIRO_ANTIALIAS_BEST);
+	cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_u32(cairo, ctx->frame_background);
+	cairo_paint(cairo);
+
+	struct render_context piece_ctx = *ctx;
+	piece_ctx.cairo = cairo;
+	piece_ctx.has_transparency = false;
+	piece_ctx.hotspot_width = 0;
+	double x = 0;
+	piece->height = render(&piece_ctx, &x, data);
+	piece->advance = x;
+	piece->background_color = piece_ctx.background_color;
+	piece->has_transparency = piece_ctx.has_transparency;
+	piece->hotspot_width = piece_ctx.hotspot_width;
+
+	// Pieces which only reported their ideal height haven't been drawn, the
+	// frame won't be committed anyway
+	if (x != 0 && piece->height <= output->height) {
+		piece->left = x < 0 ? x : 0;
+		piece->width = fabs(x);
+		piece->image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+				piece->width * output->scale, output->height * output->scale);
+		cairo_t *image_cairo = cairo_create(piece->image);
+		cairo_set_operator(image_cairo, CAIRO_OPERATOR_SOURCE);
+		cairo_set_source_surface(image_cairo, recorder,
+				-piece->left * output->scale, 0.0);
+		cairo_paint(image_cairo);
+		cairo_destroy(image_cairo);
+		if (cairo_surface_status(piece->image) != CAIRO_STATUS_SUCCESS) {
+			sway_log(SWAY_ERROR, "Failed to rasterize bar piece");
+			cairo_surface_destroy(piece->image);
+			piece->image = NULL;
+		}
+	}
+
+	cairo_destroy(cairo);
+	cairo_surface_destroy(recorder);
+	return piece;
+}
+
+static bool add_render_segment(struct render_context *ctx,
+		struct render_piece *piece, double x) {
+	if (ctx->segments_len == ctx->segments_capacity) {
+		int capacity = ctx->segments_capacity ? ctx->segments_capacity * 2 : 16;
+		struct render_segment *segments = realloc(ctx->segments,
+				capacity * sizeof(struct render_segment));
+		if (!segments) {
+			return false;
+		}
+		ctx->segments = segments;
+		ctx->segments_capacity = capacity;
+	}
+	ctx->segments[ctx->segments_len++] = (struct render_segment) {
+		.piece = piece,
+		.id = piece->id,
+		.x = x + piece->left,
+		.width = piece->width,
+	};
+	return true;
+}
+
+/**
+ * Places a piece of the bar at x and moves x past it, like the render function
+ * would. The piece is only drawn if no piece with the same key is cached.
+ * Takes ownership of the key, a NULL key disables caching.
+ */
+static uint32_t render_piece(struct render_context *ctx, char *key,
+		double *x, render_piece_func_t render, void *data) {
+	struct swaybar_output *output = ctx->output;
+	struct render_piece *piece = NULL, *iter;
+	if (key) {
+		wl_list_for_each(iter, &output->render_pieces, link) {
+			if (strcmp(iter->key, key) == 0) {
+				piece = iter;
+				break;
+			}
+		}
+	}
+	bool cached = piece != NULL;
+	if (cached) {
+		free(key);
+	} else {
+		piece = draw_render_piece(ctx, key, render, data);
+		if (!piece) {
+			return 0;
+		}
+	}
+
+	ctx->background_color = piece->background_color;
+	ctx->has_transparency |= piece->has_transparency;
+	ctx->hotspot_width = piece->hotspot_width;
+	bool placed = piece->image && add_render_segment(ctx, piece, *x);
+	*x += piece->advance;
+	uint32_t height = piece->height;
+
+	if (placed && piece->key) {
+		piece->used = true;
+		if (!cached) {
+			wl_list_insert(&output->render_pieces, &piece->link);
+		}
+	} else if (!cached) {
+		destroy_render_piece(piece);
+	}
+	return height;
+}
+
+/**
+ * Drops the pieces and text sizes the last frame didn't use.
+ */
+static void prune_render_cache(struct swaybar_output *output) {
+	struct render_piece *piece, *piece_tmp;
+	wl_list_for_each_safe(piece, piece_tmp, &output->render_pieces, link) {
+		if (piece->used) {
+			piece->used = false;
+		} else {
+			wl_list_remove(&piece->link);
+			destroy_render_piece(piece);
+		}
+	}
+	struct text_size *size, *size_tmp;
+	wl_list_for_each_safe(size, size_tmp, &output->text_sizes, link) {
+		if (size->used) {
+			size->used = false;
+		} else {
+			wl_list_remove(&size->link);
+			free(size->key);
+			free(size);
+		}
+	}
+}
+
+static uint32_t render_status_line_error(struct render_context *ctx,
+		double *x, void *data) {
 	struct swaybar_output *output = ctx->output;
 	const char *error = output->bar->status->text;
 	if (!error) {
@@ -82,7 +359,8 @@ static uint32_t render_status_line_error(struct render_context *ctx, double *x)
 	return output->height;
 }
 
-static uint32_t render_status_line_text(struct render_context *ctx, double *x) {
+static uint32_t render_status_line_text(struct render_context *ctx,
+		double *x, void *data) {
 	struct swaybar_output *output = ctx->output;
 	const char *text = output->bar->status->text;
 	if (!text) {
@@ -246,18 +524,7 @@ static uint32_t render_status_block(struct render_context *ctx,
 	}
 
 	uint32_t height = output->height;
-	if (output->bar->status->click_events) {
-		struct swaybar_hotspot *hotspot = calloc(1, sizeof(struct swaybar_hotspot));
-		hotspot->x = *x;
-		hotspot->y = 0;
-		hotspot->width = width;
-		hotspot->height = height;
-		hotspot->callback = block_hotspot_callback;
-		hotspot->destroy = i3bar_block_unref_callback;
-		hotspot->data = block;
-		block->ref_count++;
-		wl_list_insert(&output->hotspots, &hotspot->link);
-	}
+	ctx->hotspot_width = width;
 
 	double x_pos = *x;
 	double y_pos = ws_vertical_padding;
@@ -344,18 +611,89 @@ static uint32_t render_status_block(struct render_context *ctx,
 	return output->height;
 }
 
-static void predict_status_block_pos(cairo_t *cairo,
-		struct swaybar_output *output, struct i3bar_block *block, double *x,
-		bool edge) {
+struct status_block_piece {
+	struct i3bar_block *block;
+	bool edge, use_short_text;
+};
+
+static uint32_t render_status_block_piece(struct render_context *ctx,
+		double *x, void *data) {
+	struct status_block_piece *piece = data;
+	return render_status_block(ctx, piece->block, x, piece->edge,
+			piece->use_short_text);
+}
+
+static uint32_t render_cached_status_block(struct render_context *ctx,
+		struct i3bar_block *block, double *x, bool edge, bool use_short_text) {
+	if (!block->full_text || !*block->full_text) {
+		return 0;
+	}
+
+	char *text = block->full_text;
+	if (use_short_text && block->short_text && *block->short_text) {
+		text = block->short_text;
+	}
+
+	struct swaybar_output *output = ctx->output;
+	struct swaybar_config *config = output->bar->config;
+	const char *sep_symbol = config->sep_symbol ? config->sep_symbol : "";
+	const char *min_width_str = block->min_width_str ? block->min_width_str : "";
+	const char *align = block->align ? block->align : "";
+	char *key = format_piece_key(ctx, "block %d %d %d %d %d %zu:%s "
+			"%08" PRIx32 " %08" PRIx32 " %08" PRIx32 " %08" PRIx32 " "
+			"%08" PRIx32 " %08" PRIx32 " %08" PRIx32 "\n"
+			"%d %d %08" PRIx32 " %d %zu:%s %d %d %d %08" PRIx32 " "
+			"%08" PRIx32 " %d %d %d %d %d %zu:%s %s",
+			edge, output->focused, config->status_padding,
+			config->status_edge_padding, config->sep_symbol != NULL,
+			strlen(sep_symbol), sep_symbol,
+			config->colors.focused_statusline, config->colors.statusline,
+			config->colors.focused_separator, config->colors.separator,
+			config->colors.urgent_workspace.background,
+			config->colors.urgent_workspace.border,
+			config->colors.urgent_workspace.text,
+			block->urgent, block->color_set, block->color, block->min_width,
+			strlen(min_width_str), min_width_str, block->separator,
+			block->separator_block_width, block->markup, block->background,
+			block->border, block->border_set, block->border_top,
+			block->border_bottom, block->border_left, block->border_right,
+			strlen(align), align, text);
+
+	struct status_block_piece piece = {
+		.block = block,
+		.edge = edge,
+		.use_short_text = use_short_text,
+	};
+	double start = *x;
+	uint32_t height = render_piece(ctx, key, x, render_status_block_piece,
+			&piece);
+	if (*x != start && output->bar->status->click_events) {
+		struct swaybar_hotspot *hotspot = calloc(1, sizeof(struct swaybar_hotspot));
+		hotspot->x = *x;
+		hotspot->y = 0;
+		hotspot->width = ctx->hotspot_width;
+		hotspot->height = output->height;
+		hotspot->callback = block_hotspot_callback;
+		hotspot->destroy = i3bar_block_unref_callback;
+		hotspot->data = block;
+		block->ref_count++;
+		wl_list_insert(&output->hotspots, &hotspot->link);
+	}
+	return height;
+}
+
+static void predict_status_block_pos(struct render_context *ctx,
+		struct i3bar_block *block, double *x, bool edge) {
 	if (!block->full_text || !*block->full_text) {
 		return;
 	}
 
+	struct swaybar_output *output = ctx->output;
 	struct swaybar_config *config = output->bar->config;
 
 	int text_width, text_height;
-	get_text_size(cairo, config->font_description, &text_width, &text_height, NULL, 1,
-			block->markup, "%s", block->full_text);
+	get_cached_text_size(ctx, &text_width, &text_height, block->markup,
+			block->full_text);
 
 	int margin = 3;
 	double ws_vertical_padding = config->status_padding;
@@ -364,8 +702,8 @@ static void predict_status_block_pos(cairo_t *cairo,
 
 	if (block->min_width_str) {
 		int w;
-		get_text_size(cairo, config->font_description, &w, NULL, NULL,
-				1, block->markup, "%s", block->min_width_str);
+		get_cached_text_size(ctx, &w, NULL, block->markup,
+				block->min_width_str);
 		block->min_width = w;
 	}
 	if (width < block->min_width) {
@@ -391,8 +729,8 @@ static void predict_status_block_pos(cairo_t *cairo,
 	int sep_block_width = block->separator_block_width;
 	if (!edge) {
 		if (config->sep_symbol) {
-			get_text_size(cairo, config->font_description, &sep_width, &sep_height, NULL,
-					1, false, "%s", config->sep_symbol);
+			get_cached_text_size(ctx, &sep_width, &sep_height, false,
+					config->sep_symbol);
 			uint32_t _ideal_height = sep_height + ws_vertical_padding * 2;
 			uint32_t _ideal_surface_height = _ideal_height;
 			if (!output->bar->config->height &&
@@ -409,25 +747,25 @@ static void predict_status_block_pos(cairo_t *cairo,
 	}
 }
 
-static double predict_status_line_pos(cairo_t *cairo,
-		struct swaybar_output *output, double x) {
+static double predict_status_line_pos(struct render_context *ctx, double x) {
+	struct swaybar_output *output = ctx->output;
 	bool edge = x == output->width;
 	struct i3bar_block *block;
 	wl_list_for_each(block, &output->bar->status->blocks, link) {
-		predict_status_block_pos(cairo, output, block, &x, edge);
+		predict_status_block_pos(ctx, block, &x, edge);
 		edge = false;
 	}
 	return x;
 }
 
-static uint32_t predict_workspace_button_length(cairo_t *cairo,
-		struct swaybar_output *output,
+static uint32_t predict_workspace_button_length(struct render_context *ctx,
 		struct swaybar_workspace *ws) {
+	struct swaybar_output *output = ctx->output;
 	struct swaybar_config *config = output->bar->config;
 
 	int text_width, text_height;
-	get_text_size(cairo, config->font_description, &text_width, &text_height, NULL, 1,
-			config->pango_markup, "%s", ws->label);
+	get_cached_text_size(ctx, &text_width, &text_height, config->pango_markup,
+			ws->label);
 
 	int ws_vertical_padding = WS_VERTICAL_PADDING;
 	int ws_horizontal_padding = WS_HORIZONTAL_PADDING;
@@ -448,20 +786,21 @@ static uint32_t predict_workspace_button_length(cairo_t *cairo,
 	return width;
 }
 
-static uint32_t predict_workspace_buttons_length(cairo_t *cairo,
-		struct swaybar_output *output) {
+static uint32_t predict_workspace_buttons_length(struct render_context *ctx) {
+	struct swaybar_output *output = ctx->output;
 	uint32_t width = 0;
 	if (output->bar->config->workspace_buttons) {
 		struct swaybar_workspace *ws;
 		wl_list_for_each(ws, &output->workspaces, link) {
-			width += predict_workspace_button_length(cairo, output, ws);
+			width += predict_workspace_button_length(ctx, ws);
 		}
 	}
 	return width;
 }
 
-static uint32_t predict_binding_mode_indicator_length(cairo_t *cairo,
-		struct swaybar_output *output) {
+static uint32_t predict_binding_mode_indicator_length(
+		struct render_context *ctx) {
+	struct swaybar_output *output = ctx->output;
 	const char *mode = output->bar->mode;
 	if (!mode) {
 		return 0;
@@ -474,9 +813,8 @@ static uint32_t predict_binding_mode_indicator_length(cairo_t *cairo,
 	}
 
 	int text_width, text_height;
-	get_text_size(cairo, config->font_description, &text_width, &text_height, NULL,
-			1, output->bar->mode_pango_markup,
-			"%s", mode);
+	get_cached_text_size(ctx, &text_width, &text_height,
+			output->bar->mode_pango_markup, mode);
 
 	int ws_vertical_padding = WS_VERTICAL_PADDING;
 	int ws_horizontal_padding = WS_HORIZONTAL_PADDING;
@@ -503,21 +841,19 @@ static uint32_t render_status_line_i3bar(struct render_context *ctx, double *x)
 	struct i3bar_block *block;
 	bool use_short_text = false;
 
-	cairo_t *cairo = ctx->cairo;
 	double reserved_width =
-			predict_workspace_buttons_length(cairo, output) +
-			predict_binding_mode_indicator_length(cairo, output) +
+			predict_workspace_buttons_length(ctx) +
+			predict_binding_mode_indicator_length(ctx) +
 			3; // require a bit of space for margin
 
-	double predicted_full_pos =
-			predict_status_line_pos(cairo, output, *x);
+	double predicted_full_pos = predict_status_line_pos(ctx, *x);
 
 	if (predicted_full_pos < reserved_width) {
 		use_short_text = true;
 	}
 
 	wl_list_for_each(block, &output->bar->status->blocks, link) {
-		uint32_t h = render_status_block(ctx, block, x, edge,
+		uint32_t h = render_cached_status_block(ctx, block, x, edge,
 					use_short_text);
 		max_height = h > max_height ? h : max_height;
 		edge = false;
@@ -526,12 +862,27 @@ static uint32_t render_status_line_i3bar(struct render_context *ctx, double *x)
 }
 
 static uint32_t render_status_line(struct render_context *ctx, double *x) {
-	struct status_line *status = ctx->output->bar->status;
+	struct swaybar_output *output = ctx->output;
+	struct swaybar_config *config = output->bar->config;
+	struct status_line *status = output->bar->status;
+	char *key;
 	switch (status->protocol) {
 	case PROTOCOL_ERROR:
-		return render_status_line_error(ctx, x);
+		if (!status->text) {
+			return 0;
+		}
+		key = format_piece_key(ctx, "error %d\n%s",
+				config->status_padding, status->text);
+		return render_piece(ctx, key, x, render_status_line_error, NULL);
 	case PROTOCOL_TEXT:
-		return render_status_line_text(ctx, x);
+		if (!status->text) {
+			return 0;
+		}
+		key = format_piece_key(ctx, "text %d %d %d %08" PRIx32 "\n%s",
+				config->status_padding, output->focused, config->pango_markup,
+				output->focused ? config->colors.focused_statusline :
+				config->colors.statusline, status->text);
+		return render_piece(ctx, key, x, render_status_line_text, NULL);
 	case PROTOCOL_I3BAR:
 		return render_status_line_i3bar(ctx, x);
 	case PROTOCOL_UNDEF:
@@ -597,6 +948,36 @@ static struct box_size render_box(struct render_context *ctx, double x,
 	};
 }
 
+struct box_piece {
+	struct box_colors colors;
+	const char *label;
+	bool pango_markup;
+};
+
+static uint32_t render_box_piece(struct render_context *ctx, double *x,
+		void *data) {
+	struct box_piece *piece = data;
+	struct box_size size = render_box(ctx, *x, piece->colors, piece->label,
+			piece->pango_markup);
+	*x += size.width;
+	return size.height;
+}
+
+static uint32_t render_cached_box(struct render_context *ctx, double *x,
+		struct box_colors colors, const char *label, bool pango_markup) {
+	struct box_piece piece = {
+		.colors = colors,
+		.label = label,
+		.pango_markup = pango_markup,
+	};
+	char *key = format_piece_key(ctx, "box %08" PRIx32 " %08" PRIx32
+			" %08" PRIx32 " %" PRIu32 " %d\n%s", colors.background,
+			colors.border, colors.text,
+			ctx->output->bar->config->workspace_min_width, pango_markup,
+			label);
+	return render_piece(ctx, key, x, render_box_piece, &piece);
+}
+
 static uint32_t render_binding_mode_indicator(struct render_context *ctx,
 		double x) {
 	struct swaybar_output *output = ctx->output;
@@ -605,9 +986,8 @@ static uint32_t render_binding_mode_indicator(struct render_context *ctx,
 		return 0;
 	}
 
-	struct box_size size = render_box(ctx, x, output->bar->config->colors.binding_mode,
+	return render_cached_box(ctx, &x, output->bar->config->colors.binding_mode,
 			mode, output->bar->mode_pango_markup);
-	return size.height;
 }
 
 static enum hotspot_event_handling workspace_hotspot_callback(
@@ -641,31 +1021,37 @@ static uint32_t render_workspace_button(struct render_context *ctx,
 		box_colors = config->colors.inactive_workspace;
 	}
 
-	struct box_size size = render_box(ctx, *x, box_colors,
+	double start = *x;
+	uint32_t height = render_cached_box(ctx, x, box_colors,
 			ws->label, config->pango_markup);
 
 	struct swaybar_hotspot *hotspot = calloc(1, sizeof(struct swaybar_hotspot));
-	hotspot->x = *x;
+	hotspot->x = start;
 	hotspot->y = 0;
-	hotspot->width = size.width;
-	hotspot->height = size.height;
+	hotspot->width = *x - start;
+	hotspot->height = height;
 	hotspot->callback = workspace_hotspot_callback;
 	hotspot->destroy = free;
 	hotspot->data = strdup(ws->name);
 	wl_list_insert(&output->hotspots, &hotspot->link);
 
-	*x += size.width;
-	return size.height;
+	return height;
+}
+
+#if HAVE_TRAY
+static uint32_t render_tray_piece(struct render_context *ctx, double *x,
+		void *data) {
+	return render_tray(ctx->cairo, ctx->output, x);
 }
+#endif
 
 static uint32_t render_to_cairo(struct render_context *ctx) {
-	cairo_t *cairo = ctx->cairo;
 	struct swaybar_output *output = ctx->output;
 	struct swaybar *bar = output->bar;
 	struct swaybar_config *config = bar->config;
 
 	int th;
-	get_text_size(cairo, config->font_description, NULL, &th, NULL, 1, false, "");
+	get_cached_text_size(ctx, NULL, &th, false, "");
 	uint32_t max_height = (th + WS_VERTICAL_PADDING * 4);
 	/*
 	 * Each render_* function takes the actual height of the bar, and returns
@@ -676,9 +1062,15 @@ static uint32_t render_to_cairo(struct render_context *ctx) {
 	 */
 	double x = output->width;
 #if HAVE_TRAY
-	if (bar->tray) {
-		uint32_t h = render_tray(cairo, output, &x);
+	char *tray = bar->tray ? describe_tray(output) : NULL;
+	if (tray) {
+		double start = x;
+		char *key = format_piece_key(ctx, "tray %d\n%s",
+				config->tray_padding, tray);
+		uint32_t h = render_piece(ctx, key, &x, render_tray_piece, NULL);
 		max_height = h > max_height ? h : max_height;
+		add_tray_hotspots(output, start);
+		free(tray);
 	}
 #endif
 	if (bar->status) {
@@ -716,6 +1108,199 @@ static const struct wl_callback_listener output_frame_listener = {
 	.done = output_frame_handle_done
 };
 
+// Width in buffer pixels of the column tiles compared to find damage
+#define DAMAGE_TILE_WIDTH 64
+
+void render_reset_damage(struct swaybar_output *output) {
+	if (output->last_frame) {
+		cairo_surface_destroy(output->last_frame);
+		output->last_frame = NULL;
+	}
+	free(output->last_segments);
+	output->last_segments = NULL;
+	output->last_segments_len = 0;
+	free(output->last_damage);
+	output->last_damage = NULL;
+	memset(output->buffer_frames, 0, sizeof(output->buffer_frames));
+
+	struct render_piece *piece, *piece_tmp;
+	wl_list_for_each_safe(piece, piece_tmp, &output->render_pieces, link) {
+		wl_list_remove(&piece->link);
+		destroy_render_piece(piece);
+	}
+	struct text_size *size, *size_tmp;
+	wl_list_for_each_safe(size, size_tmp, &output->text_sizes, link) {
+		wl_list_remove(&size->link);
+		free(size->key);
+		free(size);
+	}
+}
+
+static bool has_segment(const struct render_segment *segments, int len,
+		const struct render_segment *segment) {
+	for (int i = 0; i < len; ++i) {
+		if (segments[i].id == segment->id && segments[i].x == segment->x &&
+				segments[i].width == segment->width) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool damage_segment(struct swaybar_output *output,
+		const struct render_segment *segment, bool *damage, int ntiles) {
+	int width = output->width * output->scale;
+	int x1 = segment->x * output->scale;
+	int x2 = x1 + segment->width * output->scale;
+	x1 = x1 < 0 ? 0 : x1;
+	x2 = x2 > width ? width : x2;
+	if (x1 >= x2) {
+		return false;
+	}
+	for (int i = x1 / DAMAGE_TILE_WIDTH; i <= (x2 - 1) / DAMAGE_TILE_WIDTH; ++i) {
+		damage[i] = true;
+	}
+	return true;
+}
+
+/**
+ * Marks the column tiles in which the frame's pieces differ from the previous
+ * frame's. Returns false if nothing changed.
+ */
+static bool find_frame_damage(struct swaybar_output *output,
+		struct render_context *ctx, bool *damage, int ntiles) {
+	cairo_surface_t *prev = output->last_frame;
+	if (!prev ||
+			cairo_image_surface_get_width(prev) != (int)(output->width * output->scale) ||
+			cairo_image_surface_get_height(prev) != (int)(output->height * output->scale) ||
+			output->last_background != ctx->frame_background) {
+		for (int i = 0; i < ntiles; ++i) {
+			damage[i] = true;
+		}
+		return true;
+	}
+
+	bool damaged = false;
+	for (int i = 0; i < ctx->segments_len; ++i) {
+		const struct render_segment *segment = &ctx->segments[i];
+		if (!has_segment(output->last_segments, output->last_segments_len,
+				segment)) {
+			damaged |= damage_segment(output, segment, damage, ntiles);
+		}
+	}
+	for (int i = 0; i < output->last_segments_len; ++i) {
+		const struct render_segment *segment = &output->last_segments[i];
+		if (!has_segment(ctx->segments, ctx->segments_len, segment)) {
+			damaged |= damage_segment(output, segment, damage, ntiles);
+		}
+	}
+	return damaged;
+}
+
+/**
+ * Redraws the damaged tiles of the frame from the background and the pieces.
+ */
+static void draw_frame_damage(struct render_context *ctx,
+		cairo_surface_t *frame, const bool *damage, int ntiles) {
+	struct swaybar_output *output = ctx->output;
+	int width = cairo_image_surface_get_width(frame);
+	int height = cairo_image_surface_get_height(frame);
+	cairo_t *cairo = cairo_create(frame);
+	cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+	for (int i = 0; i < ntiles; ) {
+		if (!damage[i]) {
+			++i;
+			continue;
+		}
+		int start = i;
+		while (i < ntiles && damage[i]) {
+			++i;
+		}
+		int x = start * DAMAGE_TILE_WIDTH;
+		int w = i * DAMAGE_TILE_WIDTH > width ?
+			width - x : (i - start) * DAMAGE_TILE_WIDTH;
+
+		cairo_save(cairo);
+		cairo_rectangle(cairo, x, 0, w, height);
+		cairo_clip(cairo);
+		cairo_set_source_u32(cairo, ctx->frame_background);
+		cairo_paint(cairo);
+		for (int j = 0; j < ctx->segments_len; ++j) {
+			const struct render_segment *segment = &ctx->segments[j];
+			int sx = segment->x * output->scale;
+			int sw = segment->width * output->scale;
+			if (sx >= x + w || sx + sw <= x) {
+				continue;
+			}
+			cairo_set_source_surface(cairo, segment->piece->image, sx, 0);
+			cairo_rectangle(cairo, sx, 0, sw, height);
+			cairo_fill(cairo);
+		}
+		cairo_restore(cairo);
+	}
+	cairo_destroy(cairo);
+	cairo_surface_flush(frame);
+}
+
+/**
+ * Copies the damaged tiles of the frame into the buffer, along with any tiles
+ * damaged since the buffer was last drawn, and damages the surface.
+ */
+static void copy_frame_damage(struct swaybar_output *output,
+		struct pool_buffer *buffer, cairo_surface_t *frame,
+		const bool *damage, int ntiles) {
+	// The buffer holds the last frame (age 1), the one before it (age 2) and
+	// thus misses the last frame's damage as well, or unknown contents
+	int slot = buffer - output->buffers;
+	uint32_t age = output->buffer_frames[slot].buffer == buffer->buffer ?
+		output->frame_serial + 1 - output->buffer_frames[slot].frame_serial : 0;
+	bool full = age == 0 || age > 2 || (age == 2 && !output->last_damage);
+	output->buffer_frames[slot].buffer = buffer->buffer;
+	output->buffer_frames[slot].frame_serial = output->frame_serial + 1;
+
+	int width = cairo_image_surface_get_width(frame);
+	int height = cairo_image_surface_get_height(frame);
+	cairo_t *shm = buffer->cairo;
+	cairo_save(shm);
+	cairo_set_operator(shm, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_surface(shm, frame, 0.0, 0.0);
+	for (int i = 0; i < ntiles; ) {
+		bool copy = full || damage[i] || (age == 2 && output->last_damage[i]);
+		if (!copy) {
+			++i;
+			continue;
+		}
+		// Merge runs of damaged tiles into a single rectangle
+		int start = i;
+		while (i < ntiles && (full || damage[i] ||
+				(age == 2 && output->last_damage[i]))) {
+			++i;
+		}
+		int x = start * DAMAGE_TILE_WIDTH;
+		int w = i * DAMAGE_TILE_WIDTH > width ?
+			width - x : (i - start) * DAMAGE_TILE_WIDTH;
+		cairo_rectangle(shm, x, 0, w, height);
+		cairo_fill(shm);
+
+		// Only the tiles which changed in this frame need to be damaged
+		for (int j = start; j < i; ++j) {
+			if (!damage[j]) {
+				continue;
+			}
+			int k = j;
+			while (k < i && damage[k]) {
+				++k;
+			}
+			int dx = j * DAMAGE_TILE_WIDTH;
+			int dw = k * DAMAGE_TILE_WIDTH > width ?
+				width - dx : (k - j) * DAMAGE_TILE_WIDTH;
+			wl_surface_damage_buffer(output->surface, dx, 0, dw, height);
+			j = k;
+		}
+	}
+	cairo_restore(shm);
+}
+
 void render_frame(struct swaybar_output *output) {
 	assert(output->surface != NULL);
 	if (!output->layer_surface) {
@@ -736,8 +1321,12 @@ void render_frame(struct swaybar_output *output) {
 		// initial background color used for deciding the best way to antialias text
 		.background_color = background_color,
 		.has_transparency = (background_color & 0xFF) != 0xFF,
+		.frame_background = background_color,
+		.font = pango_font_description_to_string(
+				output->bar->config->font_description),
 	};
 
+	// Pieces are drawn into surfaces of their own, this one only measures text
 	cairo_surface_t *recorder = cairo_recording_surface_create(
 			CAIRO_CONTENT_COLOR_ALPHA, NULL);
 	cairo_t *cairo = cairo_create(recorder);
@@ -758,11 +1347,6 @@ void render_frame(struct swaybar_output *output) {
 		ctx.textaa_sharp = fo;
 	}
 
-
-	cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
-	cairo_set_source_u32(cairo, background_color);
-	cairo_paint(cairo);
-
 	uint32_t height = render_to_cairo(&ctx);
 	int config_height = output->bar->config->height;
 	if (config_height > 0) {
@@ -783,29 +1367,67 @@ void render_frame(struct swaybar_output *output) {
 		// different height than what we asked for
 		wl_surface_commit(output->surface);
 	} else if (height > 0) {
-		// Replay recording into shm and send it off
+		// Only the regions in which the pieces of the bar changed since the
+		// last frame are redrawn, copied into a buffer and damaged
+		int buffer_width = output->width * output->scale;
+		int buffer_height = output->height * output->scale;
+		int ntiles = (buffer_width + DAMAGE_TILE_WIDTH - 1) / DAMAGE_TILE_WIDTH;
+		bool *damage = calloc(ntiles, sizeof(bool));
+		if (!damage) {
+			goto cleanup;
+		}
+		if (!find_frame_damage(output, &ctx, damage, ntiles)) {
+			// Nothing changed, keep the current buffer
+			free(damage);
+			goto cleanup;
+		}
+
+		cairo_surface_t *frame = output->last_frame;
+		bool new_frame = !frame ||
+			cairo_image_surface_get_width(frame) != buffer_width ||
+			cairo_image_surface_get_height(frame) != buffer_height;
+		if (new_frame) {
+			frame = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+					buffer_width, buffer_height);
+			if (cairo_surface_status(frame) != CAIRO_STATUS_SUCCESS) {
+				cairo_surface_destroy(frame);
+				free(damage);
+				goto cleanup;
+			}
+		}
+
 		output->current_buffer = get_next_buffer(output->bar->shm,
-				output->buffers,
-				output->width * output->scale,
-				output->height * output->scale);
+				output->buffers, buffer_width, buffer_height);
 		if (!output->current_buffer) {
+			if (new_frame) {
+				cairo_surface_destroy(frame);
+			}
+			free(damage);
 			goto cleanup;
 		}
-		cairo_t *shm = output->current_buffer->cairo;
-
-		cairo_save(shm);
-		cairo_set_operator(shm, CAIRO_OPERATOR_CLEAR);
-		cairo_paint(shm);
-		cairo_restore(shm);
 
-		cairo_set_source_surface(shm, recorder, 0.0, 0.0);
-		cairo_paint(shm);
+		draw_frame_damage(&ctx, frame, damage, ntiles);
 
 		wl_surface_set_buffer_scale(output->surface, output->scale);
 		wl_surface_attach(output->surface,
 				output->current_buffer->buffer, 0, 0);
-		wl_surface_damage(output->surface, 0, 0,
-				output->width, output->height);
+		copy_frame_damage(output, output->current_buffer, frame,
+				damage, ntiles);
+
+		if (new_frame) {
+			if (output->last_frame) {
+				cairo_surface_destroy(output->last_frame);
+			}
+			output->last_frame = frame;
+		}
+		free(output->last_damage);
+		output->last_damage = damage;
+		free(output->last_segments);
+		output->last_segments = ctx.segments;
+		output->last_segments_len = ctx.segments_len;
+		ctx.segments = NULL;
+		output->last_background = ctx.frame_background;
+		output->frame_serial++;
 
 		if (!ctx.has_transparency) {
 			struct wl_region *region =
@@ -825,6 +1447,9 @@ void render_frame(struct swaybar_output *output) {
 	}
 
 cleanup:
+	free(ctx.segments);
+	g_free(ctx.font);
+	prune_render_cache(output);
 	if (ctx.textaa_sharp != ctx.textaa_safe) {
 		cairo_font_options_destroy(ctx.textaa_sharp);
 	}
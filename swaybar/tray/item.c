@@ -20,6 +20,10 @@
 
 // TODO menu
 
+// Incremented whenever an item loads an icon, so a rendered tray can tell
+// whether its icons changed
+static uint32_t last_icon_serial = 0;
+
 static bool sni_ready(struct swaybar_sni *sni) {
 	return sni->status && (sni->status[0] == 'N' ? // NeedsAttention
 			sni->attention_icon_name || sni->attention_icon_pixmap :
@@ -432,6 +436,7 @@ static void reload_sni(struct swaybar_sni *sni, char *icon_theme,
 		if (icon_path) {
 			cairo_surface_destroy(sni->icon);
 			sni->icon = load_image(icon_path);
+			sni->icon_serial = ++last_icon_serial;
 			free(icon_path);
 			return;
 		}
@@ -454,7 +459,17 @@ static void reload_sni(struct swaybar_sni *sni, char *icon_theme,
 		sni->icon = cairo_image_surface_create_for_data(pixmap->pixels,
 				CAIRO_FORMAT_ARGB32, pixmap->size, pixmap->size,
 				cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, pixmap->size));
+		sni->icon_serial = ++last_icon_serial;
+	}
+}
+
+static int get_icon_size(struct swaybar_sni *sni, int target_size) {
+	if (!sni->icon) {
+		return target_size*0.8;
 	}
+	int actual_size = cairo_image_surface_get_height(sni->icon);
+	return actual_size < target_size ?
+		actual_size*(target_size/actual_size) : target_size;
 }
 
 uint32_t render_sni(cairo_t *cairo, struct swaybar_output *output, double *x,
@@ -476,15 +491,11 @@ uint32_t render_sni(cairo_t *cairo, struct swaybar_output *output, double *x,
 		return 0;
 	}
 
-	int icon_size;
+	int icon_size = get_icon_size(sni, target_size);
 	cairo_surface_t *icon;
 	if (sni->icon) {
-		int actual_size = cairo_image_surface_get_height(sni->icon);
-		icon_size = actual_size < target_size ?
-			actual_size*(target_size/actual_size) : target_size;
 		icon = cairo_image_surface_scale(sni->icon, icon_size, icon_size);
 	} else { // draw a :(
-		icon_size = target_size*0.8;
 		icon = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, icon_size, icon_size);
 		cairo_t *cairo_icon = cairo_create(icon);
 		cairo_set_source_u32(cairo_icon, 0xFF0000FF);
@@ -528,6 +539,26 @@ uint32_t render_sni(cairo_t *cairo, struct swaybar_output *output, double *x,
 	cairo_pattern_destroy(icon_pattern);
 	cairo_surface_destroy(icon);
 
+	return output->height;
+}
+
+void add_sni_hotspot(struct swaybar_output *output, struct swaybar_sni *sni,
+		double *x) {
+	// Passive
+	if (sni->status && sni->status[0] == 'P') {
+		return;
+	}
+
+	uint32_t height = output->height * output->scale;
+	int padding = output->bar->config->tray_padding;
+	int icon_size = get_icon_size(sni, height - 2*padding);
+
+	double descaled_padding = (double)padding / output->scale;
+	double descaled_icon_size = (double)icon_size / output->scale;
+
+	int size = descaled_icon_size + 2 * descaled_padding;
+	*x -= size;
+
 	struct swaybar_hotspot *hotspot = calloc(1, sizeof(struct swaybar_hotspot));
 	hotspot->x = *x;
 	hotspot->y = 0;
@@ -537,6 +568,4 @@ uint32_t render_sni(cairo_t *cairo, struct swaybar_output *output, double *x,
 	hotspot->destroy = free;
 	hotspot->data = strdup(sni->watcher_id);
 	wl_list_insert(&output->hotspots, &hotspot->link);
-
-	return output->height;
 }
@@ -1,4 +1,5 @@
 #include <cairo.h>
+#include <inttypes.h>
 #include <poll.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -12,6 +13,7 @@
 #include "swaybar/tray/watcher.h"
 #include "list.h"
 #include "log.h"
+#include "stringop.h"
 
 static int handle_lost_watcher(sd_bus_message *msg,
 		void *data, sd_bus_error *error) {
@@ -116,13 +118,19 @@ static int cmp_output(const void *item, const void *cmp_to) {
 	return strcmp(item, output->name);
 }
 
-uint32_t render_tray(cairo_t *cairo, struct swaybar_output *output, double *x) {
+static bool shows_tray(struct swaybar_output *output) {
 	struct swaybar_config *config = output->bar->config;
 	if (config->tray_outputs) {
-		if (list_seq_find(config->tray_outputs, cmp_output, output) == -1) {
-			return 0;
-		}
+		return list_seq_find(config->tray_outputs, cmp_output, output) != -1;
 	} // else display on all
+	return true;
+}
+
+uint32_t render_tray(cairo_t *cairo, struct swaybar_output *output, double *x) {
+	struct swaybar_config *config = output->bar->config;
+	if (!shows_tray(output)) {
+		return 0;
+	}
 
 	if ((int)(output->height * output->scale) <= 2 * config->tray_padding) {
 		return (2 * config->tray_padding + 1) / output->scale;
@@ -139,3 +147,34 @@ uint32_t render_tray(cairo_t *cairo, struct swaybar_output *output, double *x) {
 
 	return max_height;
 }
+
+void add_tray_hotspots(struct swaybar_output *output, double x) {
+	struct swaybar_config *config = output->bar->config;
+	if (!shows_tray(output) ||
+			(int)(output->height * output->scale) <= 2 * config->tray_padding) {
+		return;
+	}
+
+	struct swaybar_tray *tray = output->bar->tray;
+	for (int i = 0; i < tray->items->length; ++i) {
+		add_sni_hotspot(output, tray->items->items[i], &x);
+	}
+}
+
+char *describe_tray(struct swaybar_output *output) {
+	if (!shows_tray(output)) {
+		return NULL;
+	}
+
+	struct swaybar_tray *tray = output->bar->tray;
+	char *description = strdup("");
+	for (int i = 0; description && i < tray->items->length; ++i) {
+		struct swaybar_sni *sni = tray->items->items[i];
+		char *next = format_str("%s%zu:%s %c %" PRIu32 "\n", description,
+				strlen(sni->watcher_id), sni->watcher_id,
+				sni->status ? sni->status[0] : '-', sni->icon_serial);
+		free(description);
+		description = next;
+	}
+	return description;
+}
@@ -0,0 +1,64 @@
+#include <json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bench.h"
+#include "sway/ipc-json.h"
+#include "sway/tree/node.h"
+#include "sway/tree/workspace.h"
+
+/**
+ * Times serializing a get_tree reply for workspaces of 1k and 5k containers,
+ * both through json-c and streamed into an IPC buffer. Every container is on
+ * the seat's focus stack, so the time per container only stays flat if the
+ * focus arrays are built in one pass over the stack.
+ */
+
+static void bench_get_tree(int containers, int rounds) {
+	char name[64];
+	snprintf(name, sizeof(name), "%d", containers);
+	struct sway_workspace *ws = bench_create_workspace(name, containers);
+	int nodes = 0;
+	size_t length = 0;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < rounds; ++i) {
+		json_object *tree = ipc_json_describe_node_recursive(&ws->node);
+		length += strlen(json_object_to_json_string(tree));
+		json_object_put(tree);
+		nodes += containers;
+	}
+	snprintf(name, sizeof(name), "get_tree json-c %d containers", containers);
+	bench_report(name, nodes, &start);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < rounds; ++i) {
+		struct ipc_json_buffer buf = {0};
+		ipc_json_write_node_recursive(&buf, &ws->node, NULL, NULL);
+		if (buf.failed) {
+			fprintf(stderr, "Writing the tree failed\n");
+			exit(EXIT_FAILURE);
+		}
+		length -= buf.length;
+		free(buf.data);
+	}
+	snprintf(name, sizeof(name), "get_tree streamed %d containers", containers);
+	bench_report(name, nodes, &start);
+
+	if (length != 0) {
+		fprintf(stderr, "The streamed tree differs in length\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+int main(void) {
+	bench_server_init();
+
+	bench_get_tree(1000, 20);
+	bench_get_tree(5000, 4);
+
+	bench_server_finish();
+	return 0;
+}
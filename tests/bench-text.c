@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <wlr/types/wlr_scene.h>
+#include "bench.h"
+#include "sway/output.h"
+#include "sway/sway_text_node.h"
+#include "sway/tree/root.h"
+
+/**
+ * Times 10k title updates, each measured and rasterized, spread over one
+ * and over a hundred text nodes. Every title is different, so the shared
+ * text buffer cache never hits.
+ */
+
+#define TITLE_UPDATES 10000
+
+static void bench_title_updates(struct wlr_scene_tree *parent, int nodes) {
+	float color[4] = { 1.f, 1.f, 1.f, 1.f };
+	float background[4] = { 0.f, 0.f, 0.f, 1.f };
+	struct sway_text_node **text_nodes = calloc(nodes, sizeof(*text_nodes));
+	if (!text_nodes) {
+		fprintf(stderr, "Unable to allocate text nodes\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < nodes; ++i) {
+		text_nodes[i] = sway_text_node_create(parent, "", color, false);
+		if (!text_nodes[i]) {
+			fprintf(stderr, "Unable to create a text node\n");
+			exit(EXIT_FAILURE);
+		}
+		sway_text_node_set_background(text_nodes[i], background);
+		sway_text_node_set_max_width(text_nodes[i], 600);
+		wlr_scene_node_set_position(text_nodes[i]->node, 0,
+			i * text_nodes[i]->height % 1000);
+	}
+	sway_text_node_flush();
+
+	char title[128];
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < TITLE_UPDATES; ++i) {
+		snprintf(title, sizeof(title),
+			"~/src/sway - vim tests/bench-text.c [%d] \xe2\x80\x94 %d nodes",
+			i, nodes);
+		sway_text_node_set_text(text_nodes[i % nodes], title);
+		sway_text_node_flush();
+	}
+	snprintf(title, sizeof(title), "title updates over %d nodes", nodes);
+	bench_report(title, TITLE_UPDATES, &start);
+
+	struct wlr_scene_buffer *buffer =
+		wlr_scene_buffer_from_node(text_nodes[0]->node);
+	if (!buffer->buffer) {
+		printf("  (text was measured but not rasterized: "
+			"no output shows the text nodes)\n");
+	}
+
+	for (int i = 0; i < nodes; ++i) {
+		wlr_scene_node_destroy(text_nodes[i]->node);
+	}
+	free(text_nodes);
+}
+
+int main(void) {
+	bench_server_init();
+
+	// Text nodes are only rasterized while they are shown on an output
+	struct wlr_scene_output *scene_output = wlr_scene_output_create(
+		root->root_scene, root->fallback_output->wlr_output);
+	if (!scene_output) {
+		fprintf(stderr, "Unable to create a scene output\n");
+		return EXIT_FAILURE;
+	}
+
+	bench_title_updates(root->layers.tiling, 1);
+	bench_title_updates(root->layers.tiling, 100);
+
+	wlr_scene_output_destroy(scene_output);
+	bench_server_finish();
+	return 0;
+}
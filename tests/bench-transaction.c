@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <time.h>
+#include "bench.h"
+#include "sway/desktop/transaction.h"
+#include "sway/server.h"
+#include "sway/tree/container.h"
+#include "sway/tree/node.h"
+#include "sway/tree/workspace.h"
+
+/**
+ * Times merging dirty nodes into the pending transaction while another
+ * transaction is in flight, the case where transaction_add_node has to find
+ * the instruction a node already has. The time per node must stay the same
+ * as the tree grows.
+ */
+
+static void mark_dirty(struct sway_container *con, void *data) {
+	int *nodes = data;
+	node_set_dirty(&con->node);
+	++*nodes;
+}
+
+static void bench_merge(int containers, int rounds) {
+	char name[32];
+	snprintf(name, sizeof(name), "%d", containers);
+	struct sway_workspace *ws = bench_create_workspace(name, containers);
+
+	// With txn_wait, the first commit is queued until a timeout that never
+	// fires, and everything committed after it is merged into one pending
+	// transaction
+	transaction_commit_dirty();
+	int nodes = 0;
+	workspace_for_each_container(ws, mark_dirty, &nodes);
+	transaction_commit_dirty();
+
+	nodes = 0;
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < rounds; ++i) {
+		node_set_dirty(&ws->node);
+		workspace_for_each_container(ws, mark_dirty, &nodes);
+		transaction_commit_dirty();
+	}
+
+	snprintf(name, sizeof(name), "merge %d containers", containers);
+	bench_report(name, nodes, &start);
+}
+
+int main(void) {
+	bench_server_init();
+	debug.txn_wait = true;
+
+	bench_merge(1000, 50);
+	bench_merge(5000, 10);
+	bench_merge(20000, 3);
+
+	bench_server_finish();
+	return 0;
+}
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wlr/backend/headless.h>
+#include <wlr/types/wlr_input_method_v2.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/types/wlr_text_input_v3.h>
+#include <wlr/util/log.h>
+#include "bench.h"
+#include "list.h"
+#include "log.h"
+#include "sway/config.h"
+#include "sway/input/input-manager.h"
+#include "sway/ipc-server.h"
+#include "sway/output.h"
+#include "sway/server.h"
+#include "sway/stats.h"
+#include "sway/tree/container.h"
+#include "sway/tree/root.h"
+#include "sway/tree/workspace.h"
+
+// Defined by main.c in the sway executable
+struct sway_server server = {0};
+struct sway_debug debug = {0};
+
+void sway_terminate(int exit_code) {
+	exit(exit_code);
+}
+
+static char bench_dir[] = "/tmp/sway-bench-XXXXXX";
+static char socket_path[sizeof(bench_dir) + 16];
+static char config_path[sizeof(bench_dir) + 16];
+
+static void bench_abort(const char *message) {
+	fprintf(stderr, "%s\n", message);
+	exit(EXIT_FAILURE);
+}
+
+void bench_server_init(void) {
+	sway_log_init(SWAY_ERROR, sway_terminate);
+	wlr_log_init(WLR_ERROR, NULL);
+
+	if (!mkdtemp(bench_dir)) {
+		bench_abort("Unable to create a temporary directory");
+	}
+	snprintf(socket_path, sizeof(socket_path), "%s/ipc.sock", bench_dir);
+	snprintf(config_path, sizeof(config_path), "%s/config", bench_dir);
+
+	// Don't spawn swaybg for the empty config
+	FILE *f = fopen(config_path, "w");
+	if (!f) {
+		bench_abort("Unable to write the config file");
+	}
+	fputs("swaybg_command -\n", f);
+	fclose(f);
+
+	server.wl_display = wl_display_create();
+	server.wl_event_loop = wl_display_get_event_loop(server.wl_display);
+	root = root_create(server.wl_display);
+	if (!root) {
+		bench_abort("Unable to create root");
+	}
+
+	server.headless_backend = wlr_headless_backend_create(server.wl_event_loop);
+	if (!server.headless_backend) {
+		bench_abort("Unable to create the headless backend");
+	}
+	server.backend = server.headless_backend;
+	server.input_method = wlr_input_method_manager_v2_create(server.wl_display);
+	server.text_input = wlr_text_input_manager_v3_create(server.wl_display);
+	if (!server.input_method || !server.text_input || !sway_ext_workspace_init()) {
+		bench_abort("Unable to create the protocol managers");
+	}
+
+	struct wlr_output *wlr_output =
+		wlr_headless_add_output(server.headless_backend, 1920, 1080);
+	wlr_output_set_name(wlr_output, "FALLBACK");
+	root->fallback_output = output_create(wlr_output);
+
+	server.txn_timeout_ms = 200;
+	server.dirty_nodes = create_list();
+	server.txn_instruction_pool = create_list();
+	server.txn_list_pool = create_list();
+
+	server.input = input_manager_create(&server);
+	if (!server.input) {
+		bench_abort("Unable to create the input manager");
+	}
+	input_manager_get_default_seat();
+
+	// Keep the socket of a running sway untouched
+	setenv("SWAYSOCK", socket_path, 1);
+	ipc_init(&server);
+
+	if (!load_main_config(config_path, false, false)) {
+		bench_abort("Unable to load the config");
+	}
+	config->active = true;
+}
+
+void bench_server_finish(void) {
+	unlink(socket_path);
+	unlink(config_path);
+	rmdir(bench_dir);
+}
+
+struct sway_workspace *bench_create_workspace(const char *name,
+		int containers) {
+	struct sway_workspace *ws = workspace_create(root->fallback_output, name);
+	if (!ws) {
+		bench_abort("Unable to create a workspace");
+	}
+
+	for (int i = 0; i < containers; i += 10) {
+		struct sway_container *split = container_create(NULL);
+		if (!split) {
+			bench_abort("Unable to create a container");
+		}
+		split->pending.layout = L_VERT;
+		// Fill the split before attaching it, so that the representation of
+		// the workspace is only updated once per split
+		for (int j = i; j < containers && j < i + 10; ++j) {
+			struct sway_container *con = container_create(NULL);
+			if (!con) {
+				bench_abort("Unable to create a container");
+			}
+			container_add_child(split, con);
+		}
+		workspace_add_tiling(ws, split);
+	}
+	return ws;
+}
+
+void bench_report(const char *name, int items, const struct timespec *start) {
+	uint64_t usec = stats_elapsed_usec(start);
+	printf("%-40s %8d items %10.3f ms %10.1f ns/item\n", name, items,
+		usec / 1000.0, items ? usec * 1000.0 / items : 0.0);
+}
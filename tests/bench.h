@@ -0,0 +1,33 @@
+#ifndef _SWAY_BENCH_H
+#define _SWAY_BENCH_H
+#include <stdint.h>
+#include <time.h>
+
+struct sway_workspace;
+
+/**
+ * Set up the parts of the server that the tree, the default seat and the IPC
+ * code rely on, with an empty config and a headless output that is never
+ * enabled. No backend is started and the event loop is never dispatched, so
+ * idle and timer sources stay pending for the lifetime of the benchmark.
+ */
+void bench_server_init(void);
+
+/**
+ * Remove the IPC socket and the config file created by bench_server_init.
+ */
+void bench_server_finish(void);
+
+/**
+ * Create a workspace on the headless output holding the given number of
+ * leaf containers, in vertical splits of ten.
+ */
+struct sway_workspace *bench_create_workspace(const char *name,
+	int containers);
+
+/**
+ * Print the time elapsed since start, in total and per item.
+ */
+void bench_report(const char *name, int items, const struct timespec *start);
+
+#endif
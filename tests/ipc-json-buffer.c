@@ -0,0 +1,230 @@
+#include <json.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ipc-json-buffer.h"
+
+/**
+ * Checks that JSON written through an ipc_json_buffer matches what
+ * json_object_to_json_string produced for the IPC replies before, byte for
+ * byte, on a fixture shaped like a get_tree reply.
+ */
+
+static int failures = 0;
+
+static void check_buffer(const char *name, struct ipc_json_buffer *buf,
+		json_object *expected) {
+	const char *str = json_object_to_json_string(expected);
+	if (buf->failed) {
+		fprintf(stderr, "%s: writing failed\n", name);
+		++failures;
+	} else if (buf->length != strlen(str) ||
+			memcmp(buf->data, str, buf->length) != 0) {
+		fprintf(stderr, "%s: output differs\nwritten:  %.*s\nexpected: %s\n",
+			name, (int)buf->length, buf->data, str);
+		++failures;
+	}
+	free(buf->data);
+	*buf = (struct ipc_json_buffer){0};
+}
+
+static json_object *create_rect(int x, int y, int width, int height) {
+	json_object *rect = json_object_new_object();
+	json_object_object_add(rect, "x", json_object_new_int(x));
+	json_object_object_add(rect, "y", json_object_new_int(y));
+	json_object_object_add(rect, "width", json_object_new_int(width));
+	json_object_object_add(rect, "height", json_object_new_int(height));
+	return rect;
+}
+
+// The keys and kinds of values of a described node, in the same order
+static json_object *create_node(int id, const char *type, const char *name,
+		double percent) {
+	json_object *node = json_object_new_object();
+	json_object_object_add(node, "id", json_object_new_int(id));
+	json_object_object_add(node, "type", json_object_new_string(type));
+	json_object_object_add(node, "orientation",
+		json_object_new_string("horizontal"));
+	json_object_object_add(node, "percent",
+		percent > 0 ? json_object_new_double(percent) : NULL);
+	json_object_object_add(node, "urgent", json_object_new_boolean(id % 7 == 0));
+	json_object *marks = json_object_new_array();
+	if (id % 5 == 0) {
+		json_object_array_add(marks, json_object_new_string("a/b \"mark\""));
+	}
+	json_object_object_add(node, "marks", marks);
+	json_object_object_add(node, "focused", json_object_new_boolean(false));
+	json_object_object_add(node, "layout", json_object_new_string("splith"));
+	json_object_object_add(node, "border", json_object_new_string("normal"));
+	json_object_object_add(node, "current_border_width", json_object_new_int(2));
+	json_object_object_add(node, "rect", create_rect(-1920, 24, 1920, 1056));
+	json_object_object_add(node, "deco_rect", create_rect(0, 0, 0, 0));
+	json_object_object_add(node, "window_rect", create_rect(2, 0, 1916, 1054));
+	json_object_object_add(node, "geometry", create_rect(0, 0, 800, 600));
+	json_object_object_add(node, "name",
+		name ? json_object_new_string(name) : NULL);
+	json_object_object_add(node, "window", NULL);
+	json_object_object_add(node, "nodes", json_object_new_array());
+	json_object_object_add(node, "floating_nodes", json_object_new_array());
+	json_object *focus = json_object_new_array();
+	json_object_array_add(focus, json_object_new_int(id + 1));
+	json_object_object_add(node, "focus", focus);
+	json_object_object_add(node, "fullscreen_mode", json_object_new_int(0));
+	json_object_object_add(node, "sticky", json_object_new_boolean(false));
+	json_object_object_add(node, "floating", NULL);
+	json_object_object_add(node, "scratchpad_state", NULL);
+	return node;
+}
+
+static json_object *create_view(int id, const char *title, double percent) {
+	json_object *view = create_node(id, "con", title, percent);
+	json_object_object_add(view, "pid", json_object_new_int(4000 + id));
+	json_object_object_add(view, "app_id", NULL);
+	json_object_object_add(view, "max_render_time", json_object_new_int(0));
+	json_object_object_add(view, "shell", json_object_new_string("xwayland"));
+	json_object_object_add(view, "window", json_object_new_int(-2097151));
+	json_object *props = json_object_new_object();
+	json_object_object_add(props, "class", json_object_new_string("Firefox"));
+	json_object_object_add(props, "transient_for", NULL);
+	json_object_object_add(view, "window_properties", props);
+	return view;
+}
+
+static void add_child(json_object *parent, const char *key, json_object *child) {
+	json_object *children;
+	json_object_object_get_ex(parent, key, &children);
+	json_object_array_add(children, child);
+}
+
+static json_object *create_tree(int containers) {
+	json_object *root = create_node(1, "root", "root", 0);
+
+	json_object *scratch = create_node(2147483647, "output", "__i3", 0);
+	json_object *scratch_ws =
+		create_node(2147483646, "workspace", "__i3_scratch", 0);
+	add_child(scratch_ws, "floating_nodes",
+		create_view(3, "scratch\\pad", 1.0));
+	add_child(scratch, "nodes", scratch_ws);
+	add_child(root, "nodes", scratch);
+
+	json_object *output = create_node(4, "output", "DP-1", 1.0);
+	json_object_object_add(output, "scale", json_object_new_double(1.25));
+	json_object *configure = json_object_new_object();
+	json_object_object_add(configure, "nodes_visited",
+		json_object_new_int64(INT64_C(9007199254740993)));
+	json_object_object_add(output, "scene_configure", configure);
+	json_object_object_add(output, "features", json_object_new_object());
+	add_child(root, "nodes", output);
+
+	json_object *ws = create_node(5, "workspace", "1: \xc3\xa9t\xc3\xa9 \x01", 0);
+	json_object_object_add(ws, "num", json_object_new_int(1));
+	json_object_object_add(ws, "representation",
+		json_object_new_string("H[T[a b] V[c]]"));
+	add_child(output, "nodes", ws);
+	add_child(ws, "floating_nodes", create_view(6, "tab\tnew\nline", 0.25));
+
+	json_object *split = create_node(7, "con", NULL, 2.0 / 3.0);
+	add_child(ws, "nodes", split);
+	for (int i = 0; i < containers; ++i) {
+		char title[64];
+		snprintf(title, sizeof(title), "</title %d> \"quoted\" \b\f\r", i);
+		add_child(split, "nodes",
+			create_view(100 + i, title, 1.0 / (containers ? containers : 1)));
+	}
+	return root;
+}
+
+// Write a node the way ipc_json_write_node_recursive does, a level at a time
+static void write_node_streamed(struct ipc_json_buffer *buf,
+		json_object *node, const char *extra_key, json_object *extra_value) {
+	ipc_json_write_object_begin(buf);
+	json_object_object_foreach(node, key, value) {
+		ipc_json_write_key(buf, key);
+		if (strcmp(key, "nodes") != 0) {
+			ipc_json_write(buf, value);
+			continue;
+		}
+		ipc_json_write_array_begin(buf);
+		for (size_t i = 0; i < json_object_array_length(value); ++i) {
+			ipc_json_write_array_item(buf);
+			write_node_streamed(buf, json_object_array_get_idx(value, i),
+				NULL, NULL);
+		}
+		ipc_json_write_array_end(buf);
+	}
+	if (extra_key) {
+		ipc_json_write_key(buf, extra_key);
+		ipc_json_write(buf, extra_value);
+	}
+	ipc_json_write_object_end(buf);
+}
+
+static void test_values(void) {
+	struct ipc_json_buffer buf = {0};
+	json_object *values[] = {
+		NULL,
+		json_object_new_boolean(true),
+		json_object_new_int(-42),
+		json_object_new_int64(INT64_MIN),
+		json_object_new_double(0.1),
+		json_object_new_double(1e-7),
+		json_object_new_double(3.0),
+		json_object_new_string(""),
+		json_object_new_string("\x1f/\\\""),
+		json_object_new_object(),
+		json_object_new_array(),
+	};
+	for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+		ipc_json_write(&buf, values[i]);
+		check_buffer("values", &buf, values[i]);
+		json_object_put(values[i]);
+	}
+}
+
+static void test_tree(int containers) {
+	json_object *tree = create_tree(containers);
+	struct ipc_json_buffer buf = {0};
+
+	ipc_json_write(&buf, tree);
+	check_buffer("tree", &buf, tree);
+
+	write_node_streamed(&buf, tree, NULL, NULL);
+	check_buffer("streamed tree", &buf, tree);
+
+	// get_tree with a tree_sequence trailer on the root object
+	json_object *sequence = json_object_new_int64(INT64_C(4294967296));
+	write_node_streamed(&buf, tree, "tree_sequence", sequence);
+	json_object *with_sequence = json_object_get(tree);
+	json_object_object_add(with_sequence, "tree_sequence",
+		json_object_get(sequence));
+	check_buffer("streamed tree with sequence", &buf, with_sequence);
+	json_object_object_del(with_sequence, "tree_sequence");
+	json_object_put(with_sequence);
+	json_object_put(sequence);
+
+	// get_workspaces and other arrays of described nodes
+	json_object *workspaces = json_object_new_array();
+	json_object_array_add(workspaces, json_object_get(tree));
+	json_object_array_add(workspaces, create_node(8, "workspace", "2", 0));
+	ipc_json_write_array_begin(&buf);
+	for (size_t i = 0; i < json_object_array_length(workspaces); ++i) {
+		ipc_json_write_array_item(&buf);
+		ipc_json_write(&buf, json_object_array_get_idx(workspaces, i));
+	}
+	ipc_json_write_array_end(&buf);
+	check_buffer("array of nodes", &buf, workspaces);
+
+	json_object_put(workspaces);
+	json_object_put(tree);
+}
+
+int main(void) {
+	test_values();
+	test_tree(0);
+	test_tree(3);
+	// Large enough to grow the buffer many times
+	test_tree(2000);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}